@@ -6,6 +6,9 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#ifdef VM
+#include "vm/page-cache.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -265,6 +268,11 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
   if (inode->deny_write_cnt)
     return 0;
 
+#ifdef VM
+  /* Pages of the file kept by the page cache would go stale */
+  page_cache_invalidate (inode);
+#endif
+
   while (size > 0) 
     {
       /* Sector to write, starting byte offset within sector. */
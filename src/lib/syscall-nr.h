@@ -28,7 +28,15 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Virtual memory extensions. */
+    SYS_FORK,                   /* Duplicate this process copy-on-write. */
+    SYS_MLOCK,                  /* Lock pages in memory. */
+    SYS_MUNLOCK,                /* Unlock pages locked in memory. */
+    SYS_MADVISE,                /* Advise on the use of a range of memory. */
+    SYS_VMSTAT,                 /* Read virtual memory statistics. */
+    SYS_MMAP_ANON               /* Map anonymous zero-filled memory. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -182,3 +182,39 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+pid_t
+fork (void)
+{
+  return (pid_t) syscall0 (SYS_FORK);
+}
+
+int
+mlock (const void *addr, size_t length)
+{
+  return syscall2 (SYS_MLOCK, addr, length);
+}
+
+int
+munlock (const void *addr, size_t length)
+{
+  return syscall2 (SYS_MUNLOCK, addr, length);
+}
+
+int
+madvise (void *addr, size_t length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+int
+vmstat (struct vm_stats *stats)
+{
+  return syscall1 (SYS_VMSTAT, stats);
+}
+
+mapid_t
+mmap_anon (void *addr, size_t length)
+{
+  return syscall2 (SYS_MMAP_ANON, addr, length);
+}
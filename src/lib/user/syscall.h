@@ -2,12 +2,60 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <debug.h>
 
 /* Process identifier. */
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
 
+/* Advice for madvise. */
+#define MADV_NORMAL 0           /* No special treatment. */
+#define MADV_RANDOM 1           /* Expect page references in random order. */
+#define MADV_SEQUENTIAL 2       /* Expect page references in sequential order. */
+#define MADV_WILLNEED 3         /* Expect access in the near future. */
+#define MADV_DONTNEED 4         /* Do not expect access in the near future. */
+
+/* Sources of page faults counted by vmstat. */
+#define VM_FAULT_MMAP 0         /* Page of a memory mapped file. */
+#define VM_FAULT_STACK 1        /* Existing stack page. */
+#define VM_FAULT_DISK 2         /* Page read from the executable. */
+#define VM_FAULT_SWAP 3         /* Page read back from swap space. */
+#define VM_FAULT_SHARED 4       /* Page found in the share table. */
+#define VM_FAULT_STACK_GROWTH 5 /* New stack page. */
+#define VM_FAULT_ZERO 6         /* Read mapped to the zero page. */
+#define VM_FAULT_COW 7          /* Write to a copy-on-write page. */
+#define VM_FAULT_ANON 8         /* Page of an anonymous mapping. */
+#define VM_FAULT_SOURCES 9
+
+/* Fault latency histogram buckets, in CPU cycles.  Bucket 0 holds
+   faults under 2**VM_LATENCY_SHIFT cycles, each following bucket
+   twice as many, and the last bucket everything above. */
+#define VM_LATENCY_BUCKETS 16
+#define VM_LATENCY_SHIFT 10
+
+/* Page faults of one source. */
+struct vm_fault_stats
+  {
+    uint64_t count;                     /* Faults handled. */
+    uint64_t total_cycles;              /* Cycles spent handling them. */
+    uint64_t max_cycles;                /* Slowest fault. */
+    uint32_t latency[VM_LATENCY_BUCKETS]; /* Latency histogram. */
+  };
+
+/* Virtual memory statistics, read with vmstat(). */
+struct vm_stats
+  {
+    struct vm_fault_stats faults[VM_FAULT_SOURCES];
+    uint64_t evictions;                 /* Frames evicted. */
+    uint64_t file_writebacks;           /* Dirty mapped pages written to files. */
+    uint64_t swap_writes;               /* Pages written to the swap device. */
+    uint64_t swap_slots_used;           /* Swap device slots holding pages,
+                                           not counting the swap cache. */
+    uint64_t clock_revolutions;         /* Full turns of the clock hand. */
+  };
+
 /* Map region identifier. */
 typedef int mapid_t;
 #define MAP_FAILED ((mapid_t) -1)
@@ -45,4 +93,12 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Virtual memory extensions. */
+pid_t fork (void);
+int mlock (const void *addr, size_t length);
+int munlock (const void *addr, size_t length);
+int madvise (void *addr, size_t length, int advice);
+int vmstat (struct vm_stats *);
+mapid_t mmap_anon (void *addr, size_t length);
+
 #endif /* lib/user/syscall.h */
@@ -0,0 +1,40 @@
+/* Forks a child that shares the parent's data and stack pages
+   copy-on-write, and verifies that the writes of each process
+   are not seen by the other. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 4096)
+
+static char data[SIZE];
+
+void
+test_main (void)
+{
+  char stack_data[64];
+  pid_t child;
+
+  memset (data, 'p', sizeof data);
+  memset (stack_data, 's', sizeof stack_data);
+
+  child = fork ();
+  if (child == 0)
+    {
+      /* Child: the parent's data must be visible, then overwrite it. */
+      if (data[0] != 'p' || data[SIZE - 1] != 'p' || stack_data[0] != 's')
+        exit (-2);
+      memset (data, 'c', sizeof data);
+      memset (stack_data, 'c', sizeof stack_data);
+      exit (42);
+    }
+
+  CHECK (child != PID_ERROR, "fork");
+  CHECK (wait (child) == 42, "wait for child (should return 42)");
+
+  /* Parent: the child's writes must not be visible. */
+  CHECK (data[0] == 'p' && data[SIZE - 1] == 'p', "data unchanged by child");
+  CHECK (stack_data[0] == 's', "stack unchanged by child");
+}
@@ -0,0 +1,25 @@
+/* Locks pages of a buffer in memory, checks that they remain usable,
+   and verifies that mlock refuses unmapped addresses and requests
+   beyond the per-process quota. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES (65)
+#define SIZE (PAGES * 4096)
+
+static char buf[SIZE];
+
+void
+test_main (void)
+{
+  CHECK (mlock (buf, 4 * 4096) == 0, "mlock 4 pages");
+  memset (buf, 'm', 4 * 4096);
+  CHECK (buf[0] == 'm' && buf[4 * 4096 - 1] == 'm', "locked pages hold data");
+  CHECK (munlock (buf, 4 * 4096) == 0, "munlock 4 pages");
+
+  CHECK (mlock ((void *) 0x10000000, 4096) == -1, "mlock unmapped page fails");
+  CHECK (mlock (buf, SIZE) == -1, "mlock beyond quota fails");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mlock-quota) begin
+(mlock-quota) mlock 4 pages
+(mlock-quota) locked pages hold data
+(mlock-quota) munlock 4 pages
+(mlock-quota) mlock unmapped page fails
+(mlock-quota) mlock beyond quota fails
+(mlock-quota) end
+EOF
+pass;
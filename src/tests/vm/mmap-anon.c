@@ -0,0 +1,43 @@
+/* Maps anonymous memory, checks that it reads as zeros, fills it with
+   a pattern larger than physical memory is likely to hold and reads the
+   pattern back, then unmaps it and verifies a new mapping at the same
+   address is zero-filled again. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES (512)
+#define SIZE (PAGES * 4096)
+
+void
+test_main (void)
+{
+  char *data = (char *) 0x10000000;
+  mapid_t map;
+  size_t i;
+
+  CHECK ((map = mmap_anon (data, SIZE)) != MAP_FAILED, "mmap_anon");
+  for (i = 0; i < SIZE; i += 4096)
+    if (data[i] != 0)
+      fail ("byte %zu of new mapping is %d", i, data[i]);
+  msg ("new mapping reads as zeros");
+
+  for (i = 0; i < SIZE; i += 512)
+    data[i] = i / 512;
+  for (i = 0; i < SIZE; i += 512)
+    if (data[i] != (char) (i / 512))
+      fail ("byte %zu of mapping is %d", i, data[i]);
+  msg ("pattern read back");
+
+  munmap (map);
+  CHECK ((map = mmap_anon (data, SIZE)) != MAP_FAILED, "mmap_anon again");
+  for (i = 0; i < SIZE; i += 512)
+    if (data[i] != 0)
+      fail ("byte %zu of remapping is %d", i, data[i]);
+  msg ("remapping reads as zeros");
+  munmap (map);
+
+  CHECK (mmap_anon (data + 1, 4096) == MAP_FAILED, "misaligned mmap_anon fails");
+  CHECK (mmap_anon (NULL, 4096) == MAP_FAILED, "mmap_anon at 0 fails");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-anon) begin
+(mmap-anon) mmap_anon
+(mmap-anon) new mapping reads as zeros
+(mmap-anon) pattern read back
+(mmap-anon) mmap_anon again
+(mmap-anon) remapping reads as zeros
+(mmap-anon) misaligned mmap_anon fails
+(mmap-anon) mmap_anon at 0 fails
+(mmap-anon) end
+EOF
+pass;
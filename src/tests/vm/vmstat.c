@@ -0,0 +1,47 @@
+/* Touches pages of a buffer and verifies that vmstat counts the
+   faults, with every fault in its latency histogram. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGES (4)
+
+static char buf[PAGES * 4096];
+static struct vm_stats before, after;
+
+static uint64_t
+total_faults (const struct vm_stats *stats)
+{
+  uint64_t total = 0;
+  int i;
+
+  for (i = 0; i < VM_FAULT_SOURCES; i++)
+    total += stats->faults[i].count;
+  return total;
+}
+
+void
+test_main (void)
+{
+  int i, b;
+
+  CHECK (vmstat (&before) == 0, "vmstat before");
+  for (i = 0; i < PAGES; i++)
+    buf[i * 4096] = 'v';
+  CHECK (vmstat (&after) == 0, "vmstat after");
+
+  CHECK (total_faults (&after) >= total_faults (&before) + PAGES,
+         "faults counted");
+  for (i = 0; i < VM_FAULT_SOURCES; i++)
+    {
+      uint64_t in_histogram = 0;
+      for (b = 0; b < VM_LATENCY_BUCKETS; b++)
+        in_histogram += after.faults[i].latency[b];
+      if (in_histogram != after.faults[i].count)
+        fail ("histogram of source %d holds %d of %d faults", i,
+              (int) in_histogram, (int) after.faults[i].count);
+    }
+  msg ("histograms hold every fault");
+}
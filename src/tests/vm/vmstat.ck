@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat) begin
+(vmstat) vmstat before
+(vmstat) vmstat after
+(vmstat) faults counted
+(vmstat) histograms hold every fault
+(vmstat) end
+EOF
+pass;
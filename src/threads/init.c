@@ -40,6 +40,11 @@
 #include "vm/swap.h"
 #include "vm/frame.h"
 #include "vm/share-table.h"
+#include "vm/reclaim.h"
+#include "vm/policy.h"
+#include "vm/load-control.h"
+#include "vm/ksm.h"
+#include "vm/exec-profile.h"
 
 /* Page directory with kernel mappings only. */
 uint32_t *init_page_dir;
@@ -62,6 +67,8 @@ static size_t user_page_limit = SIZE_MAX;
 
 static void bss_init (void);
 static void paging_init (void);
+static uint32_t cpuid_features (void);
+static void cr4_set (uint32_t);
 
 static char **read_command_line (void);
 static char **parse_options (char **argv);
@@ -132,6 +139,10 @@ main (void)
   init_frame_table ();
   init_share_table ();
   initialise_swap_space ();
+  reclaim_init ();
+  load_control_init ();
+  ksm_init ();
+  exec_profile_init ();
   printf ("Boot complete.\n");
   
   /* Run actions specified on kernel command line. */
@@ -155,16 +166,36 @@ bss_init (void)
   memset (&_start_bss, 0, &_end_bss - &_start_bss);
 }
 
+/* CPUID leaf 1 feature flags in EDX.  See [IA32-v2a] "CPUID". */
+#define CPUID_PSE (1 << 3)      /* 4 MB pages. */
+#define CPUID_PGE (1 << 13)     /* Global pages. */
+
+/* CR4 flags.  See [IA32-v3a] 2.5 "Control Registers". */
+#define CR4_PSE 0x00000010      /* Page Size Extensions enable. */
+#define CR4_PGE 0x00000080      /* Page Global enable. */
+
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports 4 MB pages, every 4 MB run of RAM that
+   does not hold kernel text is mapped by a single page
+   directory entry, without a page table.  Runs holding kernel
+   text keep 4 kB pages so the text stays read-only.  If the CPU
+   supports global pages, the kernel mappings are marked global
+   so they stay in the TLB when CR3 is loaded on a process
+   switch. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  uint32_t features = cpuid_features ();
+  bool large_pages = (features & CPUID_PSE) != 0;
+  uint32_t global = (features & CPUID_PGE) != 0 ? PTE_G : 0;
+  size_t large_page_pages = PTSPAN / PGSIZE;
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -176,21 +207,57 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (large_pages && pte_idx == 0
+          && page + large_page_pages <= init_ram_pages
+          && (vaddr + PTSPAN <= &_start || &_end_kernel_text <= vaddr))
+        {
+          pd[pde_idx] = pde_create_large_kernel (vaddr, true) | global;
+          page += large_page_pages - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
           pd[pde_idx] = pde_create (pt);
         }
 
-      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
+      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text) | global;
     }
 
+  /* 4 MB pages must be enabled before they are used. */
+  if (large_pages)
+    cr4_set (CR4_PSE);
+
   /* Store the physical address of the page directory into CR3
      aka PDBR (page directory base register).  This activates our
      new page tables immediately.  See [IA32-v2a] "MOV--Move
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Global pages are enabled once the loader's mappings, which
+     are not global, are no longer in use. */
+  if (global)
+    cr4_set (CR4_PGE);
+}
+
+/* Returns the feature flags reported in EDX by CPUID leaf 1. */
+static uint32_t
+cpuid_features (void)
+{
+  uint32_t eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return edx;
+}
+
+/* Sets BITS in control register CR4. */
+static void
+cr4_set (uint32_t bits)
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4 | bits) : "memory");
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -264,6 +331,19 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-vm-low"))
+        reclaim_low_watermark = atoi (value);
+      else if (!strcmp (name, "-vm-high"))
+        reclaim_high_watermark = atoi (value);
+      else if (!strcmp (name, "-vm-ksm"))
+        ksm_enabled = true;
+      else if (!strcmp (name, "-vm-policy"))
+        {
+          if (value == NULL || !select_eviction_policy (value))
+            PANIC ("unknown eviction policy `%s' (use -h for help)", value);
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -386,6 +466,12 @@ usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -vm-low=COUNT      Reclaim frames when under COUNT pages are free.\n"
+          "  -vm-high=COUNT     Reclaim frames until COUNT pages are free.\n"
+          "  -vm-policy=NAME    Evict frames with NAME: clock (default), lru or 2q.\n"
+          "  -vm-ksm            Merge identical anonymous pages in the background.\n"
 #endif
           );
   shutdown_power_off ();
@@ -7,6 +7,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -31,6 +32,7 @@ struct pool
     struct lock lock;                   /* Mutual exclusion. */
     struct bitmap *used_map;            /* Bitmap of free pages. */
     uint8_t *base;                      /* Base of pool. */
+    size_t free_cnt;                    /* Number of free pages. */
   };
 
 /* Two pools: one for kernel data, one for user pages. */
@@ -82,7 +84,12 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   lock_release (&pool->lock);
 
   if (page_idx != BITMAP_ERROR)
-    pages = pool->base + PGSIZE * page_idx;
+    {
+      enum intr_level old_level = intr_disable ();
+      pool->free_cnt -= page_cnt;
+      intr_set_level (old_level);
+      pages = pool->base + PGSIZE * page_idx;
+    }
   else
     pages = NULL;
 
@@ -139,6 +146,35 @@ palloc_free_multiple (void *pages, size_t page_cnt)
 
   ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
   bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+
+  /* Pages can be freed with interrupts off, when the pool lock
+     cannot be taken, so the count is protected by disabling
+     interrupts instead. */
+  enum intr_level old_level = intr_disable ();
+  pool->free_cnt += page_cnt;
+  intr_set_level (old_level);
+}
+
+/* Returns the number of free pages in the user pool. */
+size_t
+palloc_user_free_pages (void) 
+{
+  return user_pool.free_cnt;
+}
+
+/* Returns the index of PAGE within the user pool. */
+size_t
+palloc_user_page_no (void *page) 
+{
+  ASSERT (page_from_pool (&user_pool, page));
+  return pg_no (page) - pg_no (user_pool.base);
+}
+
+/* Returns the number of pages in the user pool. */
+size_t
+palloc_user_pages (void) 
+{
+  return bitmap_size (user_pool.used_map);
 }
 
 /* Frees the page at PAGE. */
@@ -167,6 +203,7 @@ init_pool (struct pool *p, void *base, size_t page_cnt, const char *name)
   lock_init (&p->lock);
   p->used_map = bitmap_create_in_buf (page_cnt, base, bm_pages * PGSIZE);
   p->base = base + bm_pages * PGSIZE;
+  p->free_cnt = page_cnt;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -16,6 +16,7 @@
 #include "devices/timer.h"
 #include "vm/frame.h"
 #include "vm/share-table.h"
+#include "vm/swap.h"
 
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -163,8 +164,10 @@ thread_tick (void)
     idle_ticks++;
   }
 #ifdef USERPROG
-  else if (t->pagedir != NULL)
+  else if (t->pagedir != NULL) {
     user_ticks++;
+    t->virtual_time++;
+  }
 #endif
   else {
     kernel_ticks++;
@@ -613,6 +616,22 @@ init_thread (struct thread *t, const char *name, int priority)
 
     list_init (&t->mmapped_file_list);
     t->current_mmapped_id = 0;
+    list_init (&t->regions);
+
+    t->virtual_time = 0;
+    t->swap_read_ahead_window = SWAP_READ_AHEAD_INITIAL;
+    t->mlocked_pages = 0;
+
+    t->major_faults = 0;
+    t->fault_rate = 0;
+    t->suspend_requested = false;
+    t->suspended = false;
+    t->suspended_at = 0;
+    t->waiting_for_child = false;
+    sema_init (&t->resume_sema, 0);
+
+    t->exec_profile = NULL;
+    t->exec_start = 0;
   #endif
 
   old_level = intr_disable ();
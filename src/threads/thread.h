@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include "threads/fixed-point.h"
 #include "lib/kernel/hash.h"
+#include "threads/synch.h"
 
 /* States in a thread's life cycle. */
 enum thread_status
@@ -113,12 +114,31 @@ struct thread
     int current_file_descriptor;        /* Stores the file descriptor of the last file opened or used. */  
     struct list file_list;              /* Stores the list of files opened by the thread. */
     struct file *executable_file;       /* Pointer to the file the thread is executing. */
+    struct intr_frame *syscall_frame;   /* Interrupt frame of the system call being handled. */
 
     int current_mmapped_id;              /* Stores the mmapped id of the last file mapped */  
     struct list mmapped_file_list;       /* Stores the list of files mapped by the thread. */
     
     /* Members used for Virtual Memory */
     struct hash supp_page_table;        /* Supplemental Page Table */
+    struct list regions;                /* Regions of the address space, see vm/region.h */
+    int64_t virtual_time;               /* Ticks the process has run for, used to age its frames */
+    int swap_read_ahead_window;         /* Pages read ahead on the next swap fault */
+    size_t mlocked_pages;               /* Pages locked in memory with mlock */
+
+    /* Members used for load control, see vm/load-control.h */
+    int major_faults;                   /* Faults that read a page in during this period */
+    int fault_rate;                     /* Estimated major faults per period */
+    bool suspend_requested;             /* Records if the process is to suspend at its next safe point */
+    bool suspended;                     /* Records if the process is suspended */
+    int64_t suspended_at;               /* Tick the process was last suspended at */
+    bool waiting_for_child;             /* Records if the process is blocked in process_wait */
+    struct semaphore resume_sema;       /* Upped to resume the suspended process */
+    struct list_elem suspend_elem;      /* List elem for the suspended processes */
+
+    /* Members used for exec prefetch, see vm/exec-profile.h */
+    struct exec_profile *exec_profile;  /* Profile of the executable being recorded, NULL if none */
+    int64_t exec_start;                 /* Tick the process started running its executable at */
 #endif
     /* Owned by thread.c. */
     unsigned magic;                     /* Detects stack overflow. */
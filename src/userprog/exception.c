@@ -8,13 +8,22 @@
 #include "vm/supp-page-table.h"
 #include "lib/kernel/hash.h"
 #include "threads/palloc.h"
+#include "threads/malloc.h"
 #include "userprog/pagedir.h"
 #include "userprog/process.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
 #include "vm/frame.h"
 #include "vm/swap.h"
+#include "vm/swap-cache.h"
 #include "vm/share-table.h"
+#include "vm/reclaim.h"
+#include "vm/region.h"
+#include "vm/stats.h"
+#include "vm/load-control.h"
+#include "vm/ksm.h"
+#include "vm/page-cache.h"
+#include "vm/exec-profile.h"
 #include "string.h"
 
 /*
@@ -30,13 +39,39 @@
 /* 80x86 PUSHA instruction may cause a page fault 32 bytes below the stack pointer */
 #define PUSHA_LIMIT (32)
 
+/* Number of neighbouring file pages mapped around a faulting page */
+#define FAULT_AROUND_PAGES (8)
+
+/* Number of file pages after a faulting page mapped in regions advised sequential */
+#define SEQUENTIAL_AROUND_PAGES (16)
+
+/* Outcome of starting to load a page */
+enum page_load {
+  PAGE_LOADED,                  /* The page is mapped */
+  PAGE_NEEDS_READ,              /* The page has a frame in transit to be read into */
+  PAGE_LOAD_FAILED              /* The page could not be given a frame */
+};
+
 /* Number of page faults processed. */
 static long long page_fault_cnt;
 
+/* Number of pages mapped by fault-around. */
+static long long fault_around_pages;
+
+/* Number of read faults served by mapping the zero page. */
+static long long zero_page_mappings;
+
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 
-static bool load_page_from_filesys (supp_pte *);
+static int fault_source (supp_pte *, bool);
+static bool page_is_zero_fill (supp_pte *);
+static bool load_page (supp_pte *, bool);
+static bool load_page_from_filesys (supp_pte *, bool);
+static bool copy_on_write (void *);
+static void read_ahead_from_swap (supp_pte *, size_t, int, supp_pte **, size_t *);
+static enum region_advice page_advice (supp_pte *);
+static void drop_behind (supp_pte *);
 
 static bool acquire_table_locks (void);
 static bool release_table_locks (bool);
@@ -94,6 +129,22 @@ void
 exception_print_stats (void) 
 {
   printf ("Exception: %lld page faults\n", page_fault_cnt);
+  printf ("Fault-around: %lld pages mapped\n", fault_around_pages);
+  printf ("Zero page: %lld read faults mapped\n", zero_page_mappings);
+  printf ("Reclaim: %lld runs, %lld frames evicted\n", reclaim_runs, reclaim_pages);
+  printf ("Swap read-ahead: %lld pages read ahead, %lld hits, %lld wasted\n",
+          swap_read_ahead_pages, swap_read_ahead_hits, swap_read_ahead_wasted);
+  printf ("Load control: %lld processes suspended, %lld resumed\n",
+          load_control_suspensions, load_control_resumptions);
+  printf ("Page merging: %lld frames merged, %lld full scans\n",
+          ksm_frames_merged, ksm_full_scans);
+  printf ("Exec prefetch: %lld profiles recorded, %lld runs, %lld pages prefetched\n",
+          exec_profiles_recorded, exec_prefetch_runs, exec_prefetch_pages);
+  printf ("Page cache: %zu pages cached, %lld hits, %lld reclaimed, %lld invalidated\n",
+          page_cache_pages, page_cache_hits, page_cache_reclaimed, page_cache_invalidated);
+  printf ("Swap cache: %lld pages stored, %lld loaded, %lld rejected, %lld turned away\n",
+          swap_cache_stores, swap_cache_loads, swap_cache_rejects, swap_cache_full);
+  vm_stats_print ();
 }
 
 /* Handler for an exception (probably) caused by a user process. */
@@ -164,6 +215,7 @@ page_fault (struct intr_frame *f)
      [IA32-v3a] 5.15 "Interrupt 14--Page Fault Exception
      (#PF)". */
   asm ("movl %%cr2, %0" : "=r" (fault_addr));
+  uint64_t fault_start = vm_stats_clock ();
 
   /* Turn interrupts back on (they were only off so that we could
      be assured of reading CR2 before it changed). */
@@ -176,49 +228,44 @@ page_fault (struct intr_frame *f)
   write = (f->error_code & PF_W) != 0;
   user = (f->error_code & PF_U) != 0;
 
-  bool held = acquire_filesys_lock ();
+  /* 
+    The file system lock is not taken here, only around the file reads of
+    pages loaded from the file system, so stack and zero-fill faults never
+    wait for it
+  */
 
   /* 
    If page fault occurred because page is not present, 
    loads the page from the current thread's supplemental page table
   */
   bool load_success = false;
+  int source = VM_FAULT_DISK;
   if (not_present && is_user_vaddr (fault_addr)) {
-      struct thread *t = thread_current ();
-      supp_pte fault_entry;
-      fault_entry.uaddr = pg_round_down (fault_addr);
-
-      struct hash_elem *found_elem = hash_find (&t->supp_page_table, &fault_entry.elem);
-      if (!found_elem) {
-        load_success = false;
-      } else {
-        supp_pte *entry = hash_entry (found_elem, supp_pte, elem);
-
-        /* 
-          Determine the source of supplemental page table entry to load from
-        */
-        switch (entry->page_source) {
-          case MMAP:
-            load_success = load_page_from_filesys (entry);
-            break;
-          
-          case STACK:
-            load_success = load_from_outside_filesys (entry);
-            break;
-
-          case DISK:
-            if (entry->is_in_swap_space) {
-              load_success = load_from_outside_filesys (entry);
-            } else {
-              load_success = load_page_from_filesys (entry);
-            }
-            break;
-
-          default:
-            break;
+      supp_pte *entry = get_supp_pte (thread_current (), fault_addr);
+      if (entry != NULL) {
+        source = fault_source (entry, write);
+        load_success = load_page (entry, write);
+
+        /* A frame created by another page came from the share table */
+        frame_table_entry *frame = entry->page_frame;
+        if (load_success && source == VM_FAULT_DISK && frame != NULL
+            && frame->can_be_shared && frame->creator != entry) {
+          source = VM_FAULT_SHARED;
+        }
+
+        /* Pages read from the executable go into its profile while one is recorded */
+        if (load_success && entry->page_source == DISK && entry->read_bytes > 0) {
+          exec_profile_record (fault_addr);
         }
       }
-  } 
+  } else if (write && is_user_vaddr (fault_addr)) {
+    /*
+      Writing to a present read-only page may be a write to a page that
+      shares its frame copy-on-write
+    */
+    source = VM_FAULT_COW;
+    load_success = copy_on_write (fault_addr);
+  }
 
   /* 
     Consider stack growth 
@@ -237,47 +284,190 @@ page_fault (struct intr_frame *f)
                               || (uint32_t*) fault_addr == (uint32_t *) (f->esp - PUSHA_LIMIT)
                               || (uint32_t*) fault_addr == (uint32_t *) (f->esp - PUSH_LIMIT);
 
-  if (!load_success && not_overflow && valid_fault_address && is_user_vaddr (fault_addr)) {
+  if (!load_success && not_present && not_overflow && valid_fault_address && is_user_vaddr (fault_addr)) {
     struct hash_elem *entry_elem = set_up_pte_for_stack (fault_addr);
     supp_pte *entry = hash_entry (entry_elem, supp_pte, elem);
-    load_success = load_from_outside_filesys (entry);
+    source = VM_FAULT_STACK_GROWTH;
+    load_success = load_page (entry, write);
   }
 
-  release_filesys_lock (held);
-  
   if (!load_success) {
     exit (EXIT_ERROR);
   }
+  vm_stats_record_fault (source, fault_start);
+
+  /* Faults that read a page in count towards the process's fault rate */
+  if (source == VM_FAULT_SWAP || source == VM_FAULT_DISK || source == VM_FAULT_MMAP) {
+    thread_current ()->major_faults++;
+  }
+
+  /* A fault from user mode holds no locks, so the process may be suspended */
+  if (user) {
+    load_control_safe_point ();
+  }
+}
+
+/*
+  Returns the VM_FAULT_* source a not-present fault on the page of ENTRY
+  is loaded from
+*/
+static int
+fault_source (supp_pte *entry, bool write) {
+  if (entry->is_in_swap_space) {
+    return VM_FAULT_SWAP;
+  }
+  if (!write && page_is_zero_fill (entry)) {
+    return VM_FAULT_ZERO;
+  }
+  switch (entry->page_source) {
+    case MMAP:
+      return VM_FAULT_MMAP;
+    case STACK:
+      return VM_FAULT_STACK;
+    case ANON:
+      return VM_FAULT_ANON;
+    default:
+      return VM_FAULT_DISK;
+  }
+}
+
+/*
+  Returns true if the page of ENTRY is currently all zeros without any data
+  in a file or in swap space: untouched stack and anonymous pages and 
+  pages of the executable with no bytes to read
+*/
+static bool
+page_is_zero_fill (supp_pte *entry) {
+  if (entry->is_in_swap_space) {
+    return false;
+  }
+  return entry->page_source == STACK || entry->page_source == ANON
+         || (entry->page_source == DISK && entry->read_bytes == 0);
+}
+
+/*
+  Maps the shared zero page read-only into the page of ENTRY.
+  Returns true if successful
+*/
+static bool
+map_zero_page (supp_pte *entry) {
+  if (!install_page (entry->uaddr, zero_page, false)) {
+    return false;
+  }
+  zero_page_mappings++;
+  return true;
+}
+
+/*
+  Loads the page of ENTRY after a not-present fault. Reads of zero-filled
+  pages map the zero page, everything else is loaded into a frame
+  from the source of the page. Returns true if successful
+*/
+static bool
+load_page (supp_pte *entry, bool write) {
+  if (!write && page_is_zero_fill (entry)) {
+    return map_zero_page (entry);
+  }
+
+  /* 
+    Determine the source of supplemental page table entry to load from
+  */
+  switch (entry->page_source) {
+    case MMAP:
+      return load_page_from_filesys (entry, write);
+    
+    case STACK:
+    case ANON:
+      return load_from_outside_filesys (entry);
+
+    case DISK:
+      /* Zero-filled pages have nothing to read from the file */
+      if (entry->is_in_swap_space || page_is_zero_fill (entry)) {
+        return load_from_outside_filesys (entry);
+      }
+      return load_page_from_filesys (entry, write);
+
+    default:
+      return false;
+  }
+}
+
+/*
+  Gives the writable page containing FAULT_ADDR its own frame when it maps
+  the zero page, or its own copy of the frame it shares copy-on-write.
+  Returns false if the page is not writable
+*/
+static bool
+copy_on_write (void *fault_addr) {
+  supp_pte *entry = find_supp_pte (thread_current (), fault_addr);
+  if (entry == NULL || !entry->writable) {
+    return false;
+  }
+
+  if (entry->page_frame == NULL && pagedir_get_page (entry->thread->pagedir, entry->uaddr) == zero_page) {
+    /* First write to a page that has only been read */
+    pagedir_clear_page (entry->thread->pagedir, entry->uaddr);
+    return load_page (entry, true);
+  }
+
+  bool table_held = acquire_table_locks ();
+  bool success = break_copy_on_write (entry);
+  release_table_locks (table_held);
+  return success;
 }
 
+/*
+  Maps the frame of the share table entry holding the page of ENTRY, if
+  there is one. A frame still being read in is waited for, unless WAIT is 
+  false. Returns true if the page was mapped
+*/
 static bool
-entry_from_share_table (supp_pte *entry) {
+entry_from_share_table (supp_pte *entry, bool wait) {
 
   frame_table_entry search_frame;
   search_frame.inode = file_get_inode (entry->file);
   search_frame.ofs = entry->ofs;
+  search_frame.read_bytes = entry->read_bytes;
 
   share_entry search_entry;
   search_entry.frame = &search_frame;
 
-  struct hash_elem *search_elem = hash_find (&share_table, &search_entry.elem);
-  if (search_elem != NULL) {
+  struct hash_elem *search_elem;
+  while ((search_elem = hash_find (&share_table, &search_entry.elem)) != NULL) {
     /* 
       Page exists in share table - already allocated so elligble for sharing 
     */
     share_entry *found_entry = hash_entry (search_elem, share_entry, elem);
+    frame_table_entry *found_frame = found_entry->frame;
+
+    if (found_frame->in_transit) {
+      if (!wait) {
+        return false;
+      }
+      /* The frame may be gone once the read is done, so look it up again */
+      wait_for_frame_io (found_frame);
+      continue;
+    }
 
     /*
-      Add to list of pages that share common frame
+      Add to list of pages that share common frame. It is mapped read-only
+      even into writable pages, which get their own copy when written to
     */
-    entry->page_frame = found_entry->frame;
-    list_push_back (&found_entry->sharing_ptes, &entry->share_elem);
+    entry->page_frame = found_frame;
+    list_push_back (&found_frame->sharing_ptes, &entry->share_elem);
 
 
-    if (!install_page (entry->uaddr, found_entry->frame->kpage, entry->writable)) {
+    if (!install_page (entry->uaddr, found_frame->kpage, false)) {
+      list_remove (&entry->share_elem);
+      entry->page_frame = NULL;
       return false;
     }
 
+    /* A frame kept by the page cache is mapped again */
+    if (found_frame->cached) {
+      page_cache_claim (found_frame);
+    }
+
     return true;
   }
   
@@ -285,80 +475,316 @@ entry_from_share_table (supp_pte *entry) {
 }
 
 /*
-  Loads a page from a supplemental page table entry into an active page, 
-  using the frame table. If the page is readable, checks the share table and
-  inserts if not present. Returns true
+  Returns true if the page of ENTRY is loaded through the share table.
+  Every page of the executable is: writable ones share the frame 
+  copy-on-write until they are first written to, so a write fault gives
+  its page a private frame straight away
 */
 static bool
-load_page_from_filesys (supp_pte *entry) {
+page_is_shareable (supp_pte *entry, bool write) {
+  return entry->page_source == DISK && !(entry->writable && write);
+}
 
-  bool table_held = acquire_table_locks ();
+/*
+  Starts loading the page of a supplemental page table entry from its file,
+  using the frame table. If the page is shareable, checks the share table and
+  inserts if not present. WRITE is true if the page is loaded to be written.
+  Speculative loads only use frames that are already
+  free and do not wait for frames being read by other threads.
+  Returns PAGE_LOADED if the page was mapped from the share table and
+  PAGE_NEEDS_READ if it was given a frame in transit, which must be filled
+  by read_file_page and then passed to finish_page_load
+*/
+static enum page_load
+start_file_page (supp_pte *entry, bool speculative, bool write) {
+
+  bool shareable = page_is_shareable (entry, write);
+
+  /* 
+    A thread holding the file system lock must not wait for the read of
+    another thread, which needs that lock. It reads its own copy instead
+  */
+  bool may_wait = !speculative && !lock_held_by_current_thread (&file_system_lock);
 
-  bool shareable = !entry->writable && entry->page_source == DISK;
   /* 
-    Check for existing entry in share table for read-only pages  
+    Check for existing entry in share table for shareable pages  
   */
   if (shareable) {
-    if (entry_from_share_table (entry)) {
-      release_table_locks (table_held);;
-      return true;
+    if (entry_from_share_table (entry, may_wait)) {
+      return PAGE_LOADED;
     }
   }
 
   /*
     Try to acquire a new page of memory. 
   */
+  enum palloc_flags flags = entry->page_source == MMAP ? PAL_USER | PAL_ZERO : PAL_USER;
   frame_table_entry *new_frame;
 
-  if (entry->page_source == MMAP) {
-    new_frame = try_allocate_page (PAL_USER | PAL_ZERO, entry);
+  if (speculative) {
+    new_frame = try_allocate_free_page (flags, entry);
+    if (new_frame == NULL) {
+      return PAGE_LOAD_FAILED;
+    }
   } else {
-    new_frame = try_allocate_page (PAL_USER, entry);
+    new_frame = try_allocate_page (flags, entry);
   }
 
-
-  uint8_t *kpage = new_frame->kpage;
-
-  if (kpage == NULL) {
-    release_table_locks (table_held);
-    return false;
+  if (new_frame->kpage == NULL) {
+    return PAGE_LOAD_FAILED;
   }
   
   /* 
-    Add the page to the process's address space. 
+    The page is only mapped once it has been read
   */
-  if (!install_page (entry->uaddr, kpage, entry->writable)) {
-    free_frame_from_supp_pte (&entry->elem, thread_current ());
-    release_table_locks (table_held);
-    return false;
-  }
+  entry->page_frame = new_frame;
+  begin_frame_io (new_frame);
 
   /*
-    Add the frame to the share table if readable 
+    Add the frame to the share table if shareable, so other threads faulting
+    on the page wait for this read instead of starting their own
   */
   if (shareable) {
+    new_frame->can_be_shared = true;
     share_entry *new_share_entry = create_share_entry (entry, new_frame);
-    hash_insert (&share_table, &new_share_entry->elem);
+    if (hash_insert (&share_table, &new_share_entry->elem) != NULL) {
+      /* Another thread is already reading the page - keep this copy private */
+      list_remove (&entry->share_elem);
+      free (new_share_entry);
+      new_frame->can_be_shared = false;
+    }
   }
 
-  file_seek (entry->file, entry->ofs);
-  off_t bytes_read = file_read (entry->file, kpage, entry->read_bytes);
+  return PAGE_NEEDS_READ;
+}
+
+/*
+  Reads the page of ENTRY from its file into its frame in transit, setting
+  the remaining bytes of the page to 0. The table locks need not be held.
+  Returns true if the whole page was read
+*/
+static bool
+read_file_page (supp_pte *entry) {
+  uint8_t *kpage = entry->page_frame->kpage;
+  off_t bytes_read = file_read_at (entry->file, kpage, entry->read_bytes, entry->ofs);
 
   if (bytes_read != (off_t) entry->read_bytes) {
-    free_frame_from_supp_pte (&entry->elem, thread_current ());
+    return false;
+  }
+
+  memset (kpage + entry->read_bytes, 0, entry->zero_bytes);
+  return true;
+}
+
+/*
+  Ends the transit of the frame of ENTRY and maps it if it was filled
+  successfully, otherwise frees it. Returns true if the page was mapped
+*/
+static bool
+finish_page_load (supp_pte *entry, bool filled) {
+  frame_table_entry *f = entry->page_frame;
+
+  /* A frame that was not filled is freed while in transit, so it is not cached */
+  if (!filled) {
+    free_frame_from_supp_pte (&entry->elem, entry->thread);
+    end_frame_io (f);
+    return false;
+  }
+  end_frame_io (f);
+
+  /* Share table frames are only mapped read-only */
+  if (!install_page (entry->uaddr, f->kpage, entry->writable && !f->can_be_shared)) {
+    free_frame_from_supp_pte (&entry->elem, entry->thread);
+    return false;
+  }
+  return true;
+}
+
+/*
+  Starts loading the non-resident pages around ENTRY that come from the same
+  region of the same file, within the FAULT_AROUND_PAGES aligned window 
+  containing it. In regions advised sequential the SEQUENTIAL_AROUND_PAGES
+  pages after ENTRY are loaded instead, and in regions advised random none.
+  Pages are only loaded into frames that are already free.
+  Pages that need reading are appended to READS.
+*/
+static void
+fault_around (supp_pte *entry, supp_pte **reads, size_t *read_cnt) {
+  struct thread *t = thread_current ();
+  enum region_advice advice = page_advice (entry);
+  if (advice == ADVICE_RANDOM) {
+    return;
+  }
+
+  uintptr_t window_mask = FAULT_AROUND_PAGES * PGSIZE - 1;
+  uint8_t *window_start = (uint8_t *) ((uintptr_t) entry->uaddr & ~window_mask);
+  int window_pages = FAULT_AROUND_PAGES;
+  if (advice == ADVICE_SEQUENTIAL) {
+    window_start = entry->uaddr + PGSIZE;
+    window_pages = SEQUENTIAL_AROUND_PAGES;
+  }
+
+  for (int i = 0; i < window_pages; i++) {
+    uint8_t *upage = window_start + i * PGSIZE;
+    if (upage == entry->uaddr) {
+      continue;
+    }
+
+    /* 
+      Entries are only created for neighbours while they can be loaded
+    */
+    supp_pte *neighbour = find_supp_pte (t, upage);
+    if (neighbour == NULL && palloc_user_free_pages () > 0) {
+      neighbour = get_supp_pte (t, upage);
+    }
+    if (neighbour == NULL) {
+      continue;
+    }
+
+    /* 
+      Only pages still to be read from the same region of the same file
+    */
+    if (neighbour->page_source != entry->page_source
+        || neighbour->file != entry->file
+        || neighbour->page_frame != NULL
+        || neighbour->is_in_swap_space
+        || neighbour->read_bytes == 0
+        || neighbour->ofs - entry->ofs != upage - entry->uaddr) {
+      continue;
+    }
+
+    enum page_load state = start_file_page (neighbour, true, false);
+    if (state == PAGE_LOAD_FAILED) {
+      return;
+    }
+    if (state == PAGE_NEEDS_READ) {
+      reads[(*read_cnt)++] = neighbour;
+    } else {
+      fault_around_pages++;
+    }
+  }
+}
+
+/*
+  Loads the page of a supplemental page table entry from its file, along
+  with the neighbouring pages of the same file region that fit in free frames.
+  The table locks are released while the pages are read, and the file system
+  lock is only held for the reads. WRITE is true for a write fault.
+  Returns true if the faulting page was loaded
+*/
+static bool
+load_page_from_filesys (supp_pte *entry, bool write) {
+
+  bool table_held = acquire_table_locks ();
+
+  enum page_load state = start_file_page (entry, false, write);
+  if (state == PAGE_LOAD_FAILED) {
     release_table_locks (table_held);
     return false;
   }
 
+  supp_pte *reads[SEQUENTIAL_AROUND_PAGES + 1];
+  bool filled[SEQUENTIAL_AROUND_PAGES + 1];
+  size_t read_cnt = 0;
+  if (state == PAGE_NEEDS_READ) {
+    reads[read_cnt++] = entry;
+  }
+  fault_around (entry, reads, &read_cnt);
+  if (page_advice (entry) == ADVICE_SEQUENTIAL) {
+    drop_behind (entry);
+  }
+
+  if (read_cnt == 0) {
+    release_table_locks (table_held);
+    return true;
+  }
+
   /* 
-    Set the remaining bytes of the page to 0 
+    Every frame being read is in transit, so it is left alone while
+    the table locks are released
   */
-  memset (kpage + entry->read_bytes, NULL, entry->zero_bytes);
-  entry->page_frame = new_frame;
+  if (table_held) {
+    release_tables ();
+  }
+  bool filesys_held = acquire_filesys_lock ();
+  for (size_t i = 0; i < read_cnt; i++) {
+    filled[i] = read_file_page (reads[i]);
+  }
+  release_filesys_lock (filesys_held);
+  if (table_held) {
+    lock_tables ();
+  }
+
+  bool success = true;
+  for (size_t i = 0; i < read_cnt; i++) {
+    bool loaded = finish_page_load (reads[i], filled[i]);
+    if (reads[i] == entry) {
+      success = loaded;
+    } else if (loaded) {
+      fault_around_pages++;
+    }
+  }
+
   release_table_locks (table_held);
-  return true;
+  return success;
 }
 
+size_t
+prefetch_file_pages (void **upages, size_t count) {
+  ASSERT (count <= PREFETCH_MAX_PAGES);
+  struct thread *t = thread_current ();
+
+  bool table_held = acquire_table_locks ();
+
+  supp_pte *reads[PREFETCH_MAX_PAGES];
+  size_t read_cnt = 0;
+  size_t mapped = 0;
+  for (size_t i = 0; i < count; i++) {
+    supp_pte *entry = get_supp_pte (t, upages[i]);
+    if (entry == NULL
+        || entry->page_source != DISK
+        || entry->page_frame != NULL
+        || entry->is_in_swap_space
+        || entry->read_bytes == 0) {
+      continue;
+    }
+
+    enum page_load state = start_file_page (entry, true, false);
+    if (state == PAGE_LOAD_FAILED) {
+      /* No frame is free for the rest of the pages */
+      break;
+    }
+    if (state == PAGE_NEEDS_READ) {
+      reads[read_cnt++] = entry;
+    } else {
+      mapped++;
+    }
+  }
+
+  if (read_cnt > 0) {
+    if (table_held) {
+      release_tables ();
+    }
+    bool filesys_held = acquire_filesys_lock ();
+    bool filled[PREFETCH_MAX_PAGES];
+    for (size_t i = 0; i < read_cnt; i++) {
+      filled[i] = read_file_page (reads[i]);
+    }
+    release_filesys_lock (filesys_held);
+    if (table_held) {
+      lock_tables ();
+    }
+
+    for (size_t i = 0; i < read_cnt; i++) {
+      if (finish_page_load (reads[i], filled[i])) {
+        mapped++;
+      }
+    }
+  }
+
+  release_table_locks (table_held);
+  return mapped;
+}
 
 bool 
 load_from_outside_filesys (supp_pte *entry) {
@@ -375,27 +801,161 @@ load_from_outside_filesys (supp_pte *entry) {
     release_table_locks (table_held);
     return false;
   }
+
+  entry->page_frame = new_frame;
   
+  if (!entry->is_in_swap_space) {
+    /* New stack pages read as zeros, like the zero page they replace */
+    memset (kpage, 0, PGSIZE);
+
+    /* 
+      Try to install supplemental page table into frame 
+    */
+    if (!install_page (entry->uaddr, kpage, entry->writable)) {
+      free_frame_from_supp_pte (&entry->elem, thread_current ());
+      release_table_locks (table_held);
+      return false;
+    }
+
+    release_table_locks (table_held);
+    return true;
+  }
+
+  supp_pte *reads[SWAP_READ_AHEAD_MAX + 1];
+  size_t read_cnt = 0;
+  begin_frame_io (new_frame);
+  reads[read_cnt++] = entry;
+
   /* 
-    Try to install supplemental page table into frame 
+    Pages held in the swap cache have no neighbours on the device.
+    Regions advised random are not read ahead, and regions advised 
+    sequential always use the largest window
   */
-  if (!install_page (entry->uaddr, kpage, entry->writable)) {
-    free_frame_from_supp_pte (&entry->elem, thread_current ());
-    release_table_locks (table_held);
-    return false;
+  enum region_advice advice = page_advice (entry);
+  if (entry->swap_slot != BITMAP_ERROR && advice != ADVICE_RANDOM) {
+    int budget = advice == ADVICE_SEQUENTIAL ? SWAP_READ_AHEAD_MAX : thread_current ()->swap_read_ahead_window;
+    read_ahead_from_swap (entry, entry->swap_slot, budget, reads, &read_cnt);
   }
 
-  if (entry->is_in_swap_space) {
-    /*
-      Retrieve data from swap space and store in KPAGE  
+  /*
+    Retrieve data from swap space with the table locks released
+  */
+  if (table_held) {
+    release_tables ();
+  }
+  for (size_t i = 0; i < read_cnt; i++) {
+    retrieve_from_swap_space (reads[i], reads[i]->page_frame->kpage);
+  }
+  if (table_held) {
+    lock_tables ();
+  }
+
+  bool success = true;
+  for (size_t i = 0; i < read_cnt; i++) {
+    supp_pte *read = reads[i];
+    frame_table_entry *read_frame = read->page_frame;
+    read->is_in_swap_space = false;
+
+    if (!finish_page_load (read, true)) {
+      if (read == entry) {
+        success = false;
+      }
+      continue;
+    }
+
+    /* 
+      The swap slot has been released, so the page must be written back
+      to swap if it is evicted again, even if it is not modified
     */
-    retrieve_from_swap_space (entry, kpage);
-    entry->is_in_swap_space = false;
+    pagedir_set_dirty (read->thread->pagedir, read->uaddr, true);
+
+    if (read != entry) {
+      read_frame->prefetched = true;
+      swap_read_ahead_pages++;
+    }
   }
 
-  entry->page_frame = new_frame;
   release_table_locks (table_held);
-  return true;
+  return success;
+}
+
+/*
+  Returns the access pattern advised for the region containing the page
+  of ENTRY
+*/
+static enum region_advice
+page_advice (supp_pte *entry) {
+  region *r = find_region (entry->thread, entry->uaddr);
+  return r != NULL ? r->advice : ADVICE_NORMAL;
+}
+
+/*
+  Marks the private frames of the pages of the same region just behind
+  ENTRY, which sequential access has finished with, to be evicted before
+  other frames
+*/
+static void
+drop_behind (supp_pte *entry) {
+  struct thread *t = entry->thread;
+  region *r = find_region (t, entry->uaddr);
+
+  for (int i = 1; i <= SEQUENTIAL_AROUND_PAGES + 1; i++) {
+    uint8_t *upage = entry->uaddr - i * PGSIZE;
+    if (upage < r->start) {
+      return;
+    }
+
+    supp_pte *behind = find_supp_pte (t, upage);
+    if (behind == NULL || behind->page_frame == NULL) {
+      continue;
+    }
+
+    frame_table_entry *f = behind->page_frame;
+    if (!f->can_be_shared && !f->copy_on_write && !f->in_transit) {
+      f->drop_behind = true;
+    }
+  }
+}
+
+/*
+  Starts bringing in the neighbours of ENTRY that were swapped out next
+  to it. Pages after ENTRY are taken while they sit in the swap slots
+  directly after SWAP_SLOT, then pages before it while they sit in the
+  slots directly before. At most BUDGET pages are taken, and only into
+  frames that are already free. The pages are given frames in transit and
+  appended to READS, to be read with ENTRY.
+*/
+static void
+read_ahead_from_swap (supp_pte *entry, size_t swap_slot, int budget, supp_pte **reads, size_t *read_cnt) {
+  struct thread *t = thread_current ();
+
+  for (int direction = 1; direction >= -1 && budget > 0; direction -= 2) {
+    for (int distance = 1; budget > 0; distance++) {
+      supp_pte *neighbour = find_supp_pte (t, entry->uaddr + direction * distance * PGSIZE);
+      if (neighbour == NULL) {
+        break;
+      }
+
+      if (!neighbour->is_in_swap_space || neighbour->page_frame != NULL) {
+        break;
+      }
+
+      size_t expected_slot = swap_slot + direction * distance;
+      if (neighbour->swap_slot != expected_slot) {
+        break;
+      }
+
+      frame_table_entry *new_frame = try_allocate_free_page (PAL_USER, neighbour);
+      if (new_frame == NULL) {
+        return;
+      }
+
+      neighbour->page_frame = new_frame;
+      begin_frame_io (new_frame);
+      reads[(*read_cnt)++] = neighbour;
+      budget--;
+    }
+  }
 }
 
 
@@ -16,9 +16,21 @@ void exception_init (void);
 void exception_print_stats (void);
 
 /*
-  Loads a stack page or page from swap space corresponding to 
-  a supplemental page table entry into an active page
+  Loads a stack page, zero-filled page or page from swap space corresponding
+  to a supplemental page table entry into an active page. The file system
+  lock is not needed, and swap reads are done with the table locks released
 */
 bool load_from_outside_filesys (supp_pte *);
 
+/* Maximum number of pages prefetched by one call to prefetch_file_pages */
+#define PREFETCH_MAX_PAGES (64)
+
+/*
+  Loads the non-resident pages of the executable of the current thread at
+  the given user addresses into frames that are already free, reading them
+  in one pass in the order given. Addresses of other pages are skipped.
+  Returns the number of pages mapped
+*/
+size_t prefetch_file_pages (void **, size_t);
+
 #endif /* userprog/exception.h */
@@ -25,8 +25,11 @@
 #include "vm/frame.h"
 #include "userprog/exception.h"
 #include "vm/swap.h"
+#include "vm/region.h"
+#include "vm/exec-profile.h"
 
 static thread_func start_process NO_RETURN;
+static thread_func start_forked_process NO_RETURN;
 static bool load (const char *cmdline, void (**eip) (void), void **esp);
 static bool stack_init (int argc, char** argv, struct intr_frame* if_);
 
@@ -47,6 +50,18 @@ struct Args
   struct semaphore sema;             /* Semaphore - used so that parent process waits until its child loads successfully */
 };
 
+/*
+  Structure used to pass a parent's user context to its forked child and
+  record whether the child managed to copy the parent
+*/
+struct ForkArgs
+{
+  struct thread *parent;             /* Thread calling fork */
+  struct intr_frame if_;             /* User context of the parent at the system call */
+  bool success;                      /* Records whether the child copied the parent */
+  struct semaphore sema;             /* Semaphore - used so that parent process waits until its child is copied */
+};
+
 tid_t
 process_execute (const char *file_name) 
 {
@@ -85,6 +100,28 @@ process_execute (const char *file_name)
   return tid;
 }
 
+tid_t
+process_fork (struct intr_frame *parent_if)
+{
+  struct ForkArgs args;
+  args.parent = thread_current ();
+  args.if_ = *parent_if;
+  sema_init (&args.sema, 0);
+
+  tid_t tid = thread_create (thread_current ()->name, PRI_DEFAULT, start_forked_process, &args);
+  if (tid == TID_ERROR) {
+    return TID_ERROR;
+  }
+
+  sema_down (&args.sema);
+
+  if (!args.success) {
+    return TID_ERROR;
+  }
+
+  return tid;
+}
+
 static bool add_byte_to_stack (void **esp, uint8_t arg) {
   *esp = *esp - sizeof (uint8_t);
   *((uint8_t *)*esp) = arg;
@@ -167,11 +204,253 @@ start_process (void *args_ptr)
 
   if (!success) 
     exit (EXIT_ERROR);
+
+  /* The pages the executable usually faults on first are read in before it runs */
+  exec_profile_start (thread_current ()->executable_file);
   
   asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
   NOT_REACHED ();
 }
 
+/*
+  Gives the current thread its own handles on the executable and the open
+  files of PARENT, at the same descriptors and file positions
+*/
+static bool
+duplicate_files (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+
+  t->executable_file = file_reopen (parent->executable_file);
+  if (t->executable_file == NULL) {
+    return false;
+  }
+  file_deny_write (t->executable_file);
+
+  struct list_elem *e;
+  for (e = list_begin (&parent->file_list); e != list_end (&parent->file_list); e = list_next (e)) {
+    process_file *parent_file = list_entry (e, process_file, file_elem);
+    process_file *child_file = (process_file *) malloc (sizeof (process_file));
+    if (child_file == NULL) {
+      return false;
+    }
+
+    child_file->file = file_reopen (parent_file->file);
+    if (child_file->file == NULL) {
+      free (child_file);
+      return false;
+    }
+    file_seek (child_file->file, file_tell (parent_file->file));
+    child_file->file_descriptor = parent_file->file_descriptor;
+    list_push_back (&t->file_list, &child_file->file_elem);
+  }
+  t->current_file_descriptor = parent->current_file_descriptor;
+
+  return true;
+}
+
+/*
+  Gives the current thread the executable regions of PARENT, backed by
+  its own handle on the executable
+*/
+static bool
+duplicate_regions (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+
+  struct list_elem *e;
+  for (e = list_begin (&parent->regions); e != list_end (&parent->regions); e = list_next (e)) {
+    region *parent_region = list_entry (e, region, elem);
+    if (parent_region->map != NULL) {
+      continue;
+    }
+
+    uint32_t size = parent_region->end - parent_region->start;
+    region *child_region = create_region (t->executable_file, parent_region->ofs, parent_region->start, 
+                                          parent_region->read_bytes, size - parent_region->read_bytes, 
+                                          parent_region->writable, parent_region->page_source);
+    if (child_region == NULL) {
+      return false;
+    }
+    child_region->advice = parent_region->advice;
+  }
+  return true;
+}
+
+/*
+  Recreates the memory mapped files of PARENT in the current thread. 
+  The parent's modified pages are written back first, so the child's
+  pages, which are created when first accessed, read the same data 
+  from the files. Anonymous mappings are recreated without a file, their
+  pages are copied with the rest of the address space
+*/
+static bool
+duplicate_mappings (struct thread *parent)
+{
+  struct thread *t = thread_current ();
+
+  struct list_elem *e;
+  for (e = list_begin (&parent->mmapped_file_list); e != list_end (&parent->mmapped_file_list); e = list_next (e)) {
+    mapped_file *parent_map = list_entry (e, mapped_file, mapped_elem);
+
+    /* Each mapping gets its own reopened file, like in mmap */
+    mapped_file *map = (mapped_file *) malloc (sizeof (mapped_file));
+    if (map == NULL) {
+      return false;
+    }
+    map->file = NULL;
+    if (parent_map->file != NULL) {
+      map->file = file_reopen (parent_map->file);
+      if (map->file == NULL) {
+        free (map);
+        return false;
+      }
+    }
+    map->mapping = parent_map->mapping;
+    list_init (&map->pages);
+    list_push_back (&t->mmapped_file_list, &map->mapped_elem);
+
+    region *parent_region = parent_map->region;
+    uint32_t size = parent_region->end - parent_region->start;
+    map->region = create_region (map->file, parent_region->ofs, parent_region->start, parent_region->read_bytes,
+                                 size - parent_region->read_bytes, parent_region->writable, 
+                                 parent_region->page_source);
+    if (map->region == NULL) {
+      return false;
+    }
+    map->region->map = map;
+    map->region->advice = parent_region->advice;
+
+    struct list_elem *p;
+    for (p = list_begin (&parent_map->pages); p != list_end (&parent_map->pages); p = list_next (p)) {
+      supp_pte *parent_entry = list_entry (p, supp_pte, map_elem);
+
+      if (parent_entry->page_source == MMAP && parent_entry->page_frame != NULL
+          && pagedir_is_dirty (parent->pagedir, parent_entry->uaddr)) {
+        write_back_page (parent_entry);
+      }
+    }
+  }
+  t->current_mmapped_id = parent->current_mmapped_id;
+
+  return true;
+}
+
+/*
+  Creates the current thread's copy of a page of its parent that is not
+  memory mapped. Resident pages share the parent's frame - read-only
+  executable pages through the share table and all others copy-on-write.
+  Swapped out pages get their own copy in swap space, using SWAP_BUFFER
+*/
+static bool
+duplicate_supp_pte (supp_pte *parent_entry, void *swap_buffer)
+{
+  struct thread *t = thread_current ();
+  struct file *file = parent_entry->page_source == DISK ? t->executable_file : NULL;
+
+  supp_pte *entry = create_supp_pte (file, parent_entry->ofs, parent_entry->uaddr, parent_entry->read_bytes,
+                                     parent_entry->zero_bytes, parent_entry->writable, parent_entry->page_source);
+  if (entry == NULL) {
+    return false;
+  }
+  hash_insert (&t->supp_page_table, &entry->elem);
+
+  if (parent_entry->map != NULL) {
+    /* Pages of anonymous mappings join the child's copy of the mapping */
+    region *r = find_region (t, entry->uaddr);
+    entry->map = r->map;
+    list_push_back (&r->map->pages, &entry->map_elem);
+  }
+
+  frame_table_entry *f = parent_entry->page_frame;
+  if (f != NULL) {
+    if (f->can_be_shared) {
+      entry->page_frame = f;
+      list_push_back (&f->sharing_ptes, &entry->share_elem);
+      return install_page (entry->uaddr, f->kpage, false);
+    }
+    return share_frame_copy_on_write (parent_entry, entry);
+  }
+
+  if (parent_entry->is_in_swap_space) {
+    if (!copy_swap_page (parent_entry, entry, swap_buffer)) {
+      return false;
+    }
+    entry->is_in_swap_space = true;
+  }
+  return true;
+}
+
+/*
+  Copies the address space of PARENT into the current thread.
+  No user frame is allocated while the parent's table is walked, so
+  nothing can be evicted from under the iteration
+*/
+static bool
+duplicate_address_space (struct thread *parent)
+{
+  if (!duplicate_regions (parent) || !duplicate_mappings (parent)) {
+    return false;
+  }
+
+  void *swap_buffer = palloc_get_page (0);
+  if (swap_buffer == NULL) {
+    return false;
+  }
+
+  bool success = true;
+  struct hash_iterator i;
+  hash_first (&i, &parent->supp_page_table);
+  while (success && hash_next (&i)) {
+    supp_pte *parent_entry = hash_entry (hash_cur (&i), supp_pte, elem);
+    if (parent_entry->page_source != MMAP) {
+      success = duplicate_supp_pte (parent_entry, swap_buffer);
+    }
+  }
+
+  palloc_free_page (swap_buffer);
+  return success;
+}
+
+/*  
+  A thread function that copies the process of its parent and returns
+  to user mode at the parent's fork system call, with a return value of 0.
+*/
+static void
+start_forked_process (void *args_ptr)
+{
+  struct ForkArgs *args = args_ptr;
+  struct thread *t = thread_current ();
+  struct intr_frame if_ = args->if_;
+  bool success;
+
+  /* Initialise Supplemental Page Table of process */  
+  hash_init (&t->supp_page_table, &supp_hash, &supp_hash_compare, t);
+
+  lock_acquire (&file_system_lock);
+  lock_tables ();
+
+  t->pagedir = pagedir_create ();
+  success = t->pagedir != NULL;
+  if (success) {
+    process_activate ();
+    success = duplicate_files (args->parent) && duplicate_address_space (args->parent);
+  }
+
+  release_tables ();
+  lock_release (&file_system_lock);
+
+  args->success = success;
+  sema_up (&args->sema);
+
+  if (!success) 
+    exit (EXIT_ERROR);
+
+  if_.eax = 0;
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
 static bool stack_init(int argc, char** argv, struct intr_frame* if_)
 {
     /* Set up the stack with the tokenised arguments */
@@ -285,7 +564,11 @@ process_wait (tid_t child_tid)
   }
 
   lock_release (&pcb_list_lock);
+
+  /* A waiting process does not count as active for load control */
+  thread_current ()->waiting_for_child = true;
   sema_down (&child_pcb->wait_sema);
+  thread_current ()->waiting_for_child = false;
   return child_pcb->exit_status;
 }
 
@@ -301,9 +584,9 @@ process_exit (void)
     lock_acquire (&file_system_lock);
   }
 
-  struct list *file_list = &cur->file_list;
+  exec_profile_stop (cur);
 
-  file_close (cur->executable_file);
+  struct list *file_list = &cur->file_list;
 
   /* Close all the files opened by the process' thread */
   struct list_elem *e;
@@ -324,16 +607,22 @@ process_exit (void)
     munmap (current_file->mapping);
   }
 
+  /*
+    The pages are freed holding the file system lock, so the frames of the
+    executable can be kept in the page cache, and the executable is only 
+    closed afterwards so its inode is still open when they are
+  */
+  lock_acquire (&file_system_lock);
   lock_tables ();
 
-  lock_acquire (&swap_table_lock);
-
   hash_destroy (&cur->supp_page_table, &supp_destroy);
-
-  lock_release (&swap_table_lock);
+  destroy_regions (cur);
 
   release_tables ();
 
+  file_close (cur->executable_file);
+  lock_release (&file_system_lock);
+
   /* When a process exits, free all its child processes which have terminated */
   for (e = list_begin (&pcb_list); e != list_end (&pcb_list);) {
     pcb *child_pcb = list_entry (e, pcb, elem);
@@ -631,10 +920,35 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
   return true;
 }
 
-/* Creates the supplemental page table entries for the process from
-   which to later load frames, starting at offset OFS in FILE at address
-   UPAGE.  In total, READ_BYTES + ZERO_BYTES bytes of virtual
-   memory are initialized, as follows:
+/* Merges a page of a segment into the entry of a page already mapped by
+   an earlier segment, for segments sharing their first or last page.
+   Returns false if UPAGE is not mapped yet. */
+static bool
+merge_segment_page (uint8_t *upage, size_t page_read_bytes, bool writable)
+{
+  struct thread *t = thread_current ();
+  if (find_supp_pte (t, upage) == NULL && find_region (t, upage) == NULL)
+    return false;
+
+  /* 
+    An entry exists in the supplementary page table for this address.
+    Update its property to reflect changes of the overlapping segment. 
+  */
+  supp_pte *old_entry = get_supp_pte (t, upage);
+  if (old_entry == NULL)
+    return false;
+  old_entry->writable |= writable;
+  if (old_entry->read_bytes < page_read_bytes) {
+    old_entry->read_bytes = page_read_bytes;
+    old_entry->zero_bytes = PGSIZE - page_read_bytes;
+  }
+  return true;
+}
+
+/* Creates the region of the process from which to later load frames, 
+   starting at offset OFS in FILE at address UPAGE.  In total, 
+   READ_BYTES + ZERO_BYTES bytes of virtual memory are initialized, 
+   as follows:
 
         - READ_BYTES bytes at UPAGE must be read from FILE
           starting at offset OFS.
@@ -644,8 +958,11 @@ validate_segment (const struct Elf32_Phdr *phdr, struct file *file)
    The pages initialized by this function must be writable by the
    user process if WRITABLE is true, read-only otherwise.
 
+   No per-page state is created, except for a first or last page shared
+   with a segment loaded before, which is left out of the region.
+
    Return true if successful, false if a memory allocation error
-   or disk read error occurs. 
+   occurs. 
 */
 static bool
 setup_supp_ptes (struct file *file, off_t ofs, uint8_t *upage,
@@ -655,61 +972,46 @@ setup_supp_ptes (struct file *file, off_t ofs, uint8_t *upage,
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (ofs % PGSIZE == 0);
 
-  while (read_bytes > 0 || zero_bytes > 0) 
+  /* Leading page shared with an earlier segment */
+  if (read_bytes > 0 || zero_bytes > 0) 
     {
-      /* Calculate how to fill this page.
-         Reads PAGE_READ_BYTES bytes from FILE
-         and zero the final PAGE_ZERO_BYTES bytes. */
       size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-      size_t page_zero_bytes = PGSIZE - page_read_bytes;
-      
-      struct hash *supp_page_table = &thread_current ()->supp_page_table;
-      supp_pte old_entry_query;
-      old_entry_query.uaddr = upage;
-      struct hash_elem *old_entry_elem = hash_find (supp_page_table, &old_entry_query.elem);
-      
-      
-      if (old_entry_elem != NULL) {
-        /* 
-          An entry exists in the supplementary page table for this address.
-          Update its property to reflect changes of the overlapping segment. 
-        */
-        supp_pte *old_entry = hash_entry (old_entry_elem, supp_pte, elem);
-        old_entry->writable |= writable;
-        if (old_entry->read_bytes < page_read_bytes) {
-          old_entry->read_bytes = page_read_bytes;
-          old_entry->zero_bytes = page_zero_bytes;
+      if (merge_segment_page (upage, page_read_bytes, writable)) 
+        {
+          read_bytes -= page_read_bytes;
+          zero_bytes -= PGSIZE - page_read_bytes;
+          upage += PGSIZE;
+          ofs += PGSIZE;
         }
+    }
 
-      } else {
-        supp_pte *entry = create_supp_pte (file, ofs, upage, page_read_bytes, page_zero_bytes, writable, DISK); 
-        if (entry == NULL) {
-          return false;
+  /* Trailing page shared with an earlier segment */
+  if (read_bytes > 0 || zero_bytes > 0) 
+    {
+      uint32_t last_ofs = read_bytes + zero_bytes - PGSIZE;
+      size_t page_read_bytes = 0;
+      if (read_bytes > last_ofs)
+        page_read_bytes = read_bytes - last_ofs < PGSIZE ? read_bytes - last_ofs : PGSIZE;
+      if (merge_segment_page (upage + last_ofs, page_read_bytes, writable)) 
+        {
+          read_bytes -= page_read_bytes;
+          zero_bytes -= PGSIZE - page_read_bytes;
         }
-        hash_insert (supp_page_table, &entry->elem);
-      }
-
-      /* Advance. */
-      read_bytes -= page_read_bytes;
-      zero_bytes -= page_zero_bytes;
-      upage += PGSIZE;
-      ofs += PGSIZE;
     }
-  return true;
+
+  if (read_bytes == 0 && zero_bytes == 0)
+    return true;
+
+  return create_region (file, ofs, upage, read_bytes, zero_bytes, writable, DISK) != NULL;
 }
 
 
 struct hash_elem *
 set_up_pte_for_stack (void *upage) {
-  supp_pte *entry = (supp_pte *) malloc (sizeof (supp_pte));
+  supp_pte *entry = create_supp_pte (NULL, 0, pg_round_down (upage), 0, PGSIZE, true, STACK);
   if (!entry) {
     return NULL;
   }
-  entry->uaddr = pg_round_down (upage);
-  entry->writable = true;
-  entry->page_source = STACK;
-  entry->is_in_swap_space = false;
-  entry->thread = thread_current ();
   hash_insert (&thread_current ()->supp_page_table, &entry->elem);
   return &entry->elem;
 }
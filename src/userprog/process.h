@@ -8,6 +8,7 @@
 #include "threads/thread.h"
 #include "threads/synch.h"
 #include "vm/supp-page-table.h"
+#include "threads/interrupt.h"
 
 /*
   Global list of pcbs
@@ -27,6 +28,14 @@ extern struct lock pcb_list_lock;
 */
 tid_t process_execute (const char *file_name);
 
+/*
+  Creates a child process with a copy of the current process's address
+  space and open files, returning to user mode from the same system call
+  as the parent. Resident pages are shared copy-on-write.
+  Returns the child's thread id, or TID_ERROR if it could not be copied.
+*/
+tid_t process_fork (struct intr_frame *);
+
 /* 
   Waits for thread TID to die and returns its exit status. 
   If it was terminated by the kernel (i.e. killed due to an exception), 
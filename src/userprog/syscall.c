@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <syscall-nr.h>
 #include <string.h>
+#include <round.h>
 #include "lib/kernel/console.h"
 #include "threads/interrupt.h"
 #include "threads/thread.h"
@@ -17,6 +18,10 @@
 #include "threads/malloc.h"
 #include "lib/user/syscall.h"
 #include "vm/frame.h"
+#include "vm/swap.h"
+#include "vm/reclaim.h"
+#include "vm/stats.h"
+#include "vm/load-control.h"
 
 /* Error code for exiting process abnormally */
 #define EXIT_ERROR (-1)
@@ -36,6 +41,7 @@ static void halt_wrapper (void);
 static void exit_wrapper (int *);
 static void exec_wrapper (uint32_t *, int *);
 static void wait_wrapper (uint32_t *, int *);
+static void fork_wrapper (uint32_t *);
 static void create_wrapper (uint32_t *, int *);
 static void remove_wrapper (uint32_t *, int *);
 static void open_wrapper (uint32_t *, int *);
@@ -47,16 +53,31 @@ static void tell_wrapper (uint32_t *, int *);
 static void close_wrapper (int *);
 static void mmap_wrapper (uint32_t *, int *);
 static void munmap_wrapper (int *);
+static void mmap_anon_wrapper (uint32_t *, int *);
+static void mlock_wrapper (uint32_t *, int *);
+static void munlock_wrapper (uint32_t *, int *);
+static void madvise_wrapper (uint32_t *, int *);
+static void vmstat_wrapper (uint32_t *, int *);
 
 static process_file *find_file (int);
 static void verify_address (const void *);
 static void verify_arguments (int *, int);
 static void verify_file_ptr (const void *);
 static void verify_buffer(const void *, int);
+static void pin_buffer (const void *, unsigned, bool);
+static void unpin_buffer (const void *, unsigned);
+static unsigned io_chunk_size (const void *, unsigned);
+static void touch_page (const void *, bool);
+static bool page_range (const void *, size_t, uint8_t **, uint8_t **);
+static void advise_regions (uint8_t *, uint8_t *, enum region_advice);
+static void populate_pages (uint8_t *, uint8_t *);
+static void discard_pages (uint8_t *, uint8_t *);
 static void print_termination_output (void);
 
 static void syscall_arr_setup (void);
 static void munmap_for_thread (mapid_t, struct thread *);
+static mapid_t create_mapping (struct file *, void *, uint32_t, uint32_t, enum source);
+static mapped_file *find_mapping (mapid_t, struct thread *);
 
 void
 syscall_init (void) 
@@ -72,6 +93,9 @@ syscall_init (void)
 static void
 syscall_handler (struct intr_frame *f) 
 {
+  load_control_safe_point ();
+  thread_current ()->syscall_frame = f;
+
   int *addr = f->esp;
   verify_address (addr);
   int system_call = *addr;
@@ -161,6 +185,16 @@ wait (pid_t pid) {
   return process_wait (pid);
 }
 
+/* 
+  Wrapper function to execute fork() system call.
+  The child needs the parent's whole user context, which is taken from
+  the interrupt frame of the system call
+*/
+static void
+fork_wrapper (uint32_t *eax) {
+  *eax = process_fork (thread_current ()->syscall_frame);
+}
+
 /* 
   Wrapper function to execute create() system call 
 */
@@ -272,15 +306,34 @@ read (int fd, void *buffer, unsigned size) {
   }
 
   lock_acquire (&file_system_lock);
-
-  int bytes_read = -1;
-
   process_file *process_file = find_file (fd);
-  if (process_file) {
-    bytes_read = file_read (process_file->file, buffer, size);
+  lock_release (&file_system_lock);
+  if (process_file == NULL) {
+    return -1;
   }
 
-  lock_release (&file_system_lock);
+  /* 
+    Each chunk of the buffer is faulted in before the file system lock is
+    taken, so a large buffer never pins more than IO_CHUNK_PAGES frames
+  */
+  int bytes_read = 0;
+  uint8_t *chunk = buffer;
+  unsigned left = size;
+  while (left > 0) {
+    unsigned chunk_size = io_chunk_size (chunk, left);
+    pin_buffer (chunk, chunk_size, true);
+    lock_acquire (&file_system_lock);
+    off_t chunk_read = file_read (process_file->file, chunk, chunk_size);
+    lock_release (&file_system_lock);
+    unpin_buffer (chunk, chunk_size);
+
+    bytes_read += chunk_read;
+    if ((unsigned) chunk_read < chunk_size) {
+      break;
+    }
+    chunk += chunk_size;
+    left -= chunk_size;
+  }
 
   return bytes_read;
 }
@@ -306,16 +359,32 @@ write (int fd, const void *buffer, unsigned size) {
   }
 
   lock_acquire (&file_system_lock);
+  process_file *process_file = find_file (fd);
+  lock_release (&file_system_lock);
+  if (process_file == NULL) {
+    return 0;
+  }
 
+  /* Written a chunk at a time, like read() */
   int bytes_written = 0;
+  const uint8_t *chunk = buffer;
+  unsigned left = size;
+  while (left > 0) {
+    unsigned chunk_size = io_chunk_size (chunk, left);
+    pin_buffer (chunk, chunk_size, false);
+    lock_acquire (&file_system_lock);
+    off_t chunk_written = file_write (process_file->file, chunk, chunk_size);
+    lock_release (&file_system_lock);
+    unpin_buffer (chunk, chunk_size);
 
-  process_file *process_file = find_file (fd);
-  if (process_file) {
-    bytes_written = file_write (process_file->file, buffer, size);
+    bytes_written += chunk_written;
+    if ((unsigned) chunk_written < chunk_size) {
+      break;
+    }
+    chunk += chunk_size;
+    left -= chunk_size;
   }
 
-  lock_release (&file_system_lock);
-
   return bytes_written;
 }
 
@@ -427,56 +496,84 @@ mmap (int fd, void *addr) {
 
   lock_tables ();
 
-  int page_count = length / PGSIZE + 1;
-  for (int i = 0; i < page_count; i++) {
-    void *page = addr + PGSIZE * i;
-    struct hash *supp_page_table = &thread_current ()->supp_page_table;
-    supp_pte old_entry_query;
-    old_entry_query.uaddr = page;
-    struct hash_elem *old_entry_elem = hash_find (supp_page_table, &old_entry_query.elem);
-    if (old_entry_elem != NULL) {
-      release_tables ();
-      lock_release (&file_system_lock);
-      return MAP_FAILED;
-    }
+  uint32_t size = ROUND_UP (length, PGSIZE);
+  if (!is_user_vaddr (addr + size - 1) 
+      || !range_is_unmapped (thread_current (), addr, addr + size)) {
+    release_tables ();
+    lock_release (&file_system_lock);
+    return MAP_FAILED;
   }
 
-  mapid_t id = thread_current ()->current_mmapped_id;
+  mapid_t id = create_mapping (reopened_file, addr, length, size, MMAP);
+  if (id == MAP_FAILED) {
+    file_close (reopened_file);
+  }
 
-  off_t ofs = 0;
-  uint32_t read_bytes = length;
+  release_tables ();
+  lock_release (&file_system_lock);
+  return id;
+}
 
-  while (read_bytes > 0) {
-    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-    size_t page_zero_bytes = PGSIZE - page_read_bytes;
+/* 
+  Wrapper function to execute mmap_anon() system call 
+*/
+static void
+mmap_anon_wrapper (uint32_t *eax, int *addr) {
+  *eax = mmap_anon ((void *) *(addr + 1), (size_t) *(addr + 2));
+}
 
-    mapped_file *new_mapped_file = (mapped_file *) malloc (sizeof (mapped_file));
-    if (!new_mapped_file) {
-      release_tables ();
-      lock_release (&file_system_lock);
-      return MAP_FAILED;
-    }
+mapid_t
+mmap_anon (void *addr, size_t length) {
+  if (addr == NULL || pg_ofs (addr) != 0 || length == 0) {
+    return MAP_FAILED;
+  }
 
-    supp_pte *entry = create_supp_pte (reopened_file, ofs, addr, page_read_bytes, page_zero_bytes, true, MMAP);
-    ASSERT (entry);
-    hash_insert (&thread_current ()->supp_page_table, &entry->elem);
+  uint32_t size = ROUND_UP (length, PGSIZE);
+  if (size < length || !is_user_vaddr (addr) || (uint8_t *) addr + size < (uint8_t *) addr) {
+    return MAP_FAILED;
+  }
 
-    new_mapped_file->entry = entry;
-    new_mapped_file->mapping = id;
-    list_push_back (&thread_current ()->mmapped_file_list, &new_mapped_file->mapped_elem);
-    
-    read_bytes -= page_read_bytes;
-    addr += PGSIZE;
-    ofs += PGSIZE;
+  lock_tables ();
+
+  if (!is_user_vaddr ((uint8_t *) addr + size - 1)
+      || !range_is_unmapped (thread_current (), addr, (uint8_t *) addr + size)) {
+    release_tables ();
+    return MAP_FAILED;
   }
 
-  release_tables ();
-  lock_release (&file_system_lock);
+  mapid_t id = create_mapping (NULL, addr, 0, size, ANON);
 
-  thread_current ()->current_mmapped_id++;
+  release_tables ();
   return id;
 }
 
+/*
+  Creates a mapping of SIZE bytes at ADDR in the current thread, whose
+  first READ_BYTES bytes are read from FILE and the rest zeroed. Anonymous
+  mappings have no file. The table locks must be held.
+  Returns the ID of the mapping, or MAP_FAILED if memory allocation fails
+*/
+static mapid_t
+create_mapping (struct file *file, void *addr, uint32_t read_bytes, uint32_t size, enum source source) {
+  struct thread *t = thread_current ();
+  mapped_file *new_mapped_file = (mapped_file *) malloc (sizeof (mapped_file));
+  if (!new_mapped_file) {
+    return MAP_FAILED;
+  }
+  /* Pages of the mapping only get entries once they are accessed */
+  new_mapped_file->region = create_region (file, 0, addr, read_bytes, size - read_bytes, true, source);
+  if (!new_mapped_file->region) {
+    free (new_mapped_file);
+    return MAP_FAILED;
+  }
+  new_mapped_file->region->map = new_mapped_file;
+  new_mapped_file->mapping = t->current_mmapped_id++;
+  new_mapped_file->file = file;
+  list_init (&new_mapped_file->pages);
+  list_push_back (&t->mmapped_file_list, &new_mapped_file->mapped_elem);
+  return new_mapped_file->mapping;
+}
+
 /* 
   Wrapper function to execute munmap() system call 
 */
@@ -494,41 +591,274 @@ munmap (mapid_t mapping) {
   lock_release (&file_system_lock);
 }
 
+/* 
+  Wrapper function to execute mlock() system call 
+*/
+static void
+mlock_wrapper (uint32_t *eax, int *addr) {
+  *eax = mlock ((const void *) *(addr + 1), (size_t) *(addr + 2));
+}
+
+int
+mlock (const void *addr, size_t length) {
+  uint8_t *start;
+  uint8_t *end;
+  if (!page_range (addr, length, &start, &end)) {
+    return EXIT_ERROR;
+  }
+
+  struct thread *t = thread_current ();
+  lock_tables ();
+
+  /* Every page must exist, and only pages not yet locked count against the quotas */
+  size_t new_pages = 0;
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    supp_pte *entry = get_supp_pte (t, upage);
+    if (entry == NULL) {
+      release_tables ();
+      return EXIT_ERROR;
+    }
+    if (!entry->mlocked) {
+      new_pages++;
+    }
+  }
+
+  if (t->mlocked_pages + new_pages > MLOCK_QUOTA_PAGES 
+      || mlocked_pages + new_pages > MLOCK_LIMIT_PAGES) {
+    release_tables ();
+    return EXIT_ERROR;
+  }
+
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    supp_pte *entry = find_supp_pte (t, upage);
+    if (!entry->mlocked) {
+      entry->mlocked = true;
+      entry->pin_count++;
+    }
+  }
+  t->mlocked_pages += new_pages;
+  mlocked_pages += new_pages;
+
+  release_tables ();
+
+  /* The pages are pinned, so once faulted in they stay resident */
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    touch_page (upage, false);
+  }
+  return 0;
+}
+
+/* 
+  Wrapper function to execute munlock() system call 
+*/
+static void
+munlock_wrapper (uint32_t *eax, int *addr) {
+  *eax = munlock ((const void *) *(addr + 1), (size_t) *(addr + 2));
+}
+
+int
+munlock (const void *addr, size_t length) {
+  uint8_t *start;
+  uint8_t *end;
+  if (!page_range (addr, length, &start, &end)) {
+    return EXIT_ERROR;
+  }
+
+  struct thread *t = thread_current ();
+  lock_tables ();
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    supp_pte *entry = find_supp_pte (t, upage);
+    if (entry != NULL) {
+      release_page_lock (entry);
+    }
+  }
+  release_tables ();
+  return 0;
+}
+
+/* 
+  Wrapper function to execute madvise() system call 
+*/
+static void
+madvise_wrapper (uint32_t *eax, int *addr) {
+  *eax = madvise ((void *) *(addr + 1), (size_t) *(addr + 2), *(addr + 3));
+}
+
+int
+madvise (void *addr, size_t length, int advice) {
+  uint8_t *start;
+  uint8_t *end;
+  if (pg_ofs (addr) != 0 || !page_range (addr, length, &start, &end)) {
+    return EXIT_ERROR;
+  }
+
+  switch (advice) {
+    case MADV_NORMAL:
+      advise_regions (start, end, ADVICE_NORMAL);
+      return 0;
+
+    case MADV_RANDOM:
+      advise_regions (start, end, ADVICE_RANDOM);
+      return 0;
+
+    case MADV_SEQUENTIAL:
+      advise_regions (start, end, ADVICE_SEQUENTIAL);
+      return 0;
+
+    case MADV_WILLNEED:
+      populate_pages (start, end);
+      return 0;
+
+    case MADV_DONTNEED:
+      discard_pages (start, end);
+      return 0;
+
+    default:
+      return EXIT_ERROR;
+  }
+}
+
+/* 
+  Wrapper function to execute vmstat() system call 
+*/
+static void
+vmstat_wrapper (uint32_t *eax, int *addr) {
+  *eax = vmstat ((struct vm_stats *) *(addr + 1));
+}
+
+int
+vmstat (struct vm_stats *stats) {
+  verify_buffer (stats, sizeof *stats);
+
+  /* Taken first, so faults on the buffer do not change the copy */
+  struct vm_stats snapshot;
+  vm_stats_snapshot (&snapshot);
+  memcpy (stats, &snapshot, sizeof snapshot);
+  return 0;
+}
+
+/*
+  Sets the access pattern advice of the regions overlapping the pages from
+  START up to END. Regions are advised as a whole
+*/
+static void
+advise_regions (uint8_t *start, uint8_t *end, enum region_advice advice) {
+  struct thread *t = thread_current ();
+  lock_tables ();
+
+  struct list_elem *e;
+  for (e = list_begin (&t->regions); e != list_end (&t->regions); e = list_next (e)) {
+    region *r = list_entry (e, region, elem);
+    if (r->start < end && start < r->end) {
+      r->advice = advice;
+    }
+  }
+
+  release_tables ();
+}
+
+/*
+  Faults in the pages from START up to END, as long as free frames are left
+  above the reclaim low watermark, so populating them never evicts. 
+  Fault-around and swap read-ahead bring neighbouring pages in together
+*/
+static void
+populate_pages (uint8_t *start, uint8_t *end) {
+  struct thread *t = thread_current ();
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    if (palloc_user_free_pages () <= reclaim_low_watermark) {
+      return;
+    }
+
+    if (find_supp_pte (t, upage) == NULL && find_region (t, upage) == NULL) {
+      continue;
+    }
+    touch_page (upage, false);
+  }
+}
+
+/*
+  Releases the frames and swap slots of the pages from START up to END.
+  Modified pages of memory mapped files are written back first, other pages
+  lose their contents and are loaded from their file or zeroed again when
+  next accessed. Pinned pages are left alone
+*/
+static void
+discard_pages (uint8_t *start, uint8_t *end) {
+  struct thread *t = thread_current ();
+  lock_acquire (&file_system_lock);
+  lock_tables ();
+
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    supp_pte *entry = find_supp_pte (t, upage);
+    if (entry == NULL || entry->pin_count > 0) {
+      continue;
+    }
+
+    if (entry->page_frame != NULL && entry->page_source == MMAP
+        && pagedir_is_dirty (t->pagedir, entry->uaddr)) {
+      write_back_page (entry);
+    }
+    free_frame_from_supp_pte (&entry->elem, t);
+
+    if (entry->is_in_swap_space) {
+      release_swap_slot (entry);
+      entry->is_in_swap_space = false;
+    }
+  }
+
+  release_tables ();
+  lock_release (&file_system_lock);
+}
+
 /* Unmapps file of mapid mapping from memory of given thread  */
 static void
 munmap_for_thread (mapid_t mapping, struct thread *given_thread) {
-  mapid_t MIN_ID = 0;
-
-  if (mapping < MIN_ID) {
+  mapped_file *map = find_mapping (mapping, given_thread);
+  if (map == NULL) {
     return;
   }
 
-  struct list *mapped_list = &given_thread->mmapped_file_list;
+  /* Only the pages of this mapping are visited */
+  while (!list_empty (&map->pages)) {
+    supp_pte *entry = list_entry (list_pop_front (&map->pages), supp_pte, map_elem);
+    if (entry->page_frame != NULL && entry->page_source == MMAP
+        && pagedir_is_dirty (given_thread->pagedir, entry->uaddr)) {
+      write_back_page (entry);
+    }
 
-  if (list_empty (mapped_list)) {
-    return;
+    release_page_lock (entry);
+    free_frame_from_supp_pte (&entry->elem, given_thread);
+    if (entry->is_in_swap_space) {
+      /* Pages of anonymous mappings are swapped out like stack pages */
+      release_swap_slot (entry);
+    }
+    
+    hash_delete (&given_thread->supp_page_table, &entry->elem);
+    free (entry);
   }
 
+  destroy_region (map->region);
+  list_remove (&map->mapped_elem);
+  file_close (map->file);
+  free (map);
+}
+
+/* 
+  Finds the memory mapping with id mapping of the given thread.
+  Returns NULL if the thread has no such mapping
+*/
+static mapped_file *
+find_mapping (mapid_t mapping, struct thread *given_thread) {
+  struct list *mapped_list = &given_thread->mmapped_file_list;
   struct list_elem *e;
-  for (e = list_begin (mapped_list); e != list_end (mapped_list);) {
+  for (e = list_begin (mapped_list); e != list_end (mapped_list); e = list_next (e)) {
     mapped_file *current_mapped_file = list_entry (e, mapped_file, mapped_elem);
     if (current_mapped_file->mapping == mapping) {
-      supp_pte *entry = current_mapped_file->entry;
-      if (pagedir_is_dirty (given_thread->pagedir, entry->uaddr)) {
-        file_write_at (entry->file, entry->page_frame->kpage, entry->read_bytes, entry->ofs);
-      }
-
-      free_frame_from_supp_pte (&entry->elem, given_thread);
-      
-      hash_delete (&given_thread->supp_page_table, &entry->elem);
-      free (entry);
-      
-      e = list_remove (e);
-      free (current_mapped_file);
-    } else {
-      e = list_next (e);
+      return current_mapped_file;
     }
   }
+  return NULL;
 }
 
 
@@ -568,6 +898,90 @@ verify_buffer (const void *buffer, int size) {
   verify_address (buffer + size);
 }
 
+/*
+  Pins the pages of a verified buffer and faults them in, so the buffer can
+  be accessed while holding the file system lock without faulting. Pages
+  the kernel will WRITE to are faulted in writable
+*/
+static void
+pin_buffer (const void *buffer, unsigned size, bool write) {
+  struct thread *t = thread_current ();
+  uint8_t *start;
+  uint8_t *end;
+  if (!page_range (buffer, size, &start, &end)) {
+    return;
+  }
+
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    if (pin_page (t, upage) != NULL) {
+      touch_page (upage, write);
+    }
+  }
+}
+
+/*
+  Returns how many of the LEFT bytes from CHUNK fit in the IO_CHUNK_PAGES
+  user pages starting with the page of CHUNK
+*/
+static unsigned
+io_chunk_size (const void *chunk, unsigned left) {
+  unsigned limit = IO_CHUNK_PAGES * PGSIZE - pg_ofs (chunk);
+  return left < limit ? left : limit;
+}
+
+/*
+  Removes the pins pin_buffer put on the pages of the buffer
+*/
+static void
+unpin_buffer (const void *buffer, unsigned size) {
+  struct thread *t = thread_current ();
+  uint8_t *start;
+  uint8_t *end;
+  if (!page_range (buffer, size, &start, &end)) {
+    return;
+  }
+
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    supp_pte *entry = find_supp_pte (t, upage);
+    if (entry != NULL) {
+      unpin_page (entry);
+    }
+  }
+}
+
+/*
+  Accesses the user page, faulting it in if it is not resident. With WRITE,
+  the page is also given its own writable frame
+*/
+static void
+touch_page (const void *upage, bool write) {
+  volatile uint8_t *byte = (volatile uint8_t *) upage;
+  uint8_t value = *byte;
+  if (write) {
+    *byte = value;
+  }
+}
+
+/*
+  Finds the user pages covering LENGTH bytes from ADDR, from START up to
+  but excluding END. Returns false if the range is empty or not in user space
+*/
+static bool
+page_range (const void *addr, size_t length, uint8_t **start, uint8_t **end) {
+  if (length == 0 || addr == NULL || !is_user_vaddr (addr)) {
+    return false;
+  }
+
+  uintptr_t last = (uintptr_t) addr + length - 1;
+  if (last < (uintptr_t) addr || !is_user_vaddr ((const void *) last)) {
+    return false;
+  }
+
+  *start = pg_round_down (addr);
+  *end = (uint8_t *) pg_round_down ((const void *) last) + PGSIZE;
+  return true;
+}
+
 /* 
   Verifies the address of a file pointer, even if it lies on multiple pages 
 */
@@ -598,13 +1012,9 @@ verify_address (const void *vaddr) {
     exit (EXIT_ERROR);
   }
 
-  /* Search for an entry in the supplemental page table */
-  struct hash *supp_page_table = &thread_current ()->supp_page_table;
-  supp_pte old_entry_query;
-  old_entry_query.uaddr = pg_round_down (vaddr);
-  struct hash_elem *old_entry_elem = hash_find (supp_page_table, &old_entry_query.elem);
-  
-  if (!old_entry_elem) {
+  /* Search for an entry in the supplemental page table, or a region to create it from */
+  struct thread *t = thread_current ();
+  if (!find_supp_pte (t, vaddr) && !find_region (t, vaddr)) {
     exit (EXIT_ERROR);
   }
 }
@@ -633,7 +1043,7 @@ print_termination_output (void) {
   Initialise syscall_arr to store information about each system call function
 */
 static void syscall_arr_setup(void) {
-  for (int i = SYS_HALT; i <= SYS_INUMBER; i++) {
+  for (int i = SYS_HALT; i < NUM_SYSCALLS; i++) {
     syscall_func_info info = {0};
     switch (i)
     {
@@ -726,6 +1136,42 @@ static void syscall_arr_setup(void) {
         info.func = &munmap_wrapper;
         info.has_return = false;
         break;
+
+      case SYS_FORK:
+        info.num_args = 0;
+        info.func = &fork_wrapper;
+        info.has_return = true;
+        break;
+
+      case SYS_MLOCK:
+        info.num_args = 2;
+        info.func = &mlock_wrapper;
+        info.has_return = true;
+        break;
+
+      case SYS_MUNLOCK:
+        info.num_args = 2;
+        info.func = &munlock_wrapper;
+        info.has_return = true;
+        break;
+
+      case SYS_MADVISE:
+        info.num_args = 3;
+        info.func = &madvise_wrapper;
+        info.has_return = true;
+        break;
+
+      case SYS_VMSTAT:
+        info.num_args = 1;
+        info.func = &vmstat_wrapper;
+        info.has_return = true;
+        break;
+
+      case SYS_MMAP_ANON:
+        info.num_args = 2;
+        info.func = &mmap_anon_wrapper;
+        info.has_return = true;
+        break;
         
       default:
         break;
@@ -4,9 +4,13 @@
 #include <list.h>
 #include "lib/user/syscall.h"
 #include "vm/supp-page-table.h"
+#include "vm/region.h"
 
 /* Current number of system call functions recognised in Pintos */
-#define NUM_SYSCALLS (20) 
+#define NUM_SYSCALLS (26) 
+
+/* Maximum number of buffer pages read() and write() pin at once */
+#define IO_CHUNK_PAGES (8)
 
 /*
     Struct to map file pointers to file descriptors
@@ -19,12 +23,15 @@ typedef struct
 } process_file;
 
 /*
-    Struct to map supplemental page table entries for memory mapped files to mapids
+    Struct for a memory mapped file, holding the supplemental page table 
+    entries of its pages. Each entry points back to its mapping
 */
-typedef struct
+typedef struct mapped_file
 {
-    supp_pte *entry;                     /* Supplemental Page Table entry corresponding to the mapping */
     mapid_t mapping;                     /* ID of the mapping */
+    struct file *file;                   /* File reopened for the mapping. NULL for anonymous mappings */
+    region *region;                      /* Region of the address space covered by the mapping */
+    struct list pages;                   /* Supplemental Page Table entries of the accessed mapped pages */
     struct list_elem mapped_elem;        /* List elem - each thread contains a list of memory mapped files */
 } mapped_file;
 
@@ -131,9 +138,39 @@ void close (int fd);
 */
 mapid_t mmap (int fd, void *addr);
 
+/* 
+  System call that maps length bytes of zero-filled memory, backed by swap
+  space, at address addr. Returns the ID of the mapping, or MAP_FAILED
+*/
+mapid_t mmap_anon (void *addr, size_t length);
+
 /* 
   System call that unmapps file of mapid mapping from memory.
 */
 void munmap (mapid_t mapping);
 
+/* 
+  System call that locks the pages covering length bytes from addr in 
+  memory, within the process's quota. Returns 0 if successful, otherwise -1
+*/
+int mlock (const void *addr, size_t length);
+
+/* 
+  System call that unlocks the pages covering length bytes from addr.
+  Returns 0 if successful, otherwise -1
+*/
+int munlock (const void *addr, size_t length);
+
+/* 
+  System call that advises how the pages covering length bytes from addr 
+  will be used. Returns 0 if successful, otherwise -1
+*/
+int madvise (void *addr, size_t length, int advice);
+
+/* 
+  System call that copies the virtual memory statistics into stats.
+  Returns 0
+*/
+int vmstat (struct vm_stats *stats);
+
 #endif /* userprog/syscall.h */
@@ -0,0 +1,173 @@
+#include "vm/exec-profile.h"
+#include <debug.h>
+#include <stdlib.h>
+#include <string.h>
+#include "filesys/inode.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+long long exec_profiles_recorded;
+long long exec_prefetch_runs;
+long long exec_prefetch_pages;
+
+/*
+  Pages of an executable faulted on soon after it started
+*/
+struct exec_profile {
+  bool in_use;                          /* Records whether the profile holds an executable */
+  bool recording;                       /* Records whether a process is still recording it */
+  block_sector_t inumber;               /* Inode number of the executable */
+  int64_t last_used;                    /* Tick the executable was last started at */
+  size_t page_cnt;                      /* Number of pages recorded */
+  void *pages[EXEC_PROFILE_PAGES];      /* User addresses of the pages, in fault order */
+};
+
+static struct exec_profile profiles[EXEC_PROFILES];
+
+/* Lock to ensure synchronized access to the profiles. No lock is taken while holding it */
+static struct lock exec_profile_lock;
+
+static struct exec_profile *find_profile (block_sector_t);
+static struct exec_profile *replace_profile (void);
+static void finish_recording (struct thread *);
+static int compare_pages (const void *, const void *);
+
+void
+exec_profile_init (void) {
+  lock_init (&exec_profile_lock);
+}
+
+void
+exec_profile_start (struct file *executable) {
+  struct thread *t = thread_current ();
+  block_sector_t inumber = inode_get_inumber (file_get_inode (executable));
+  void *pages[EXEC_PROFILE_PAGES];
+  size_t page_cnt = 0;
+
+  lock_acquire (&exec_profile_lock);
+
+  struct exec_profile *p = find_profile (inumber);
+  if (p == NULL) {
+    p = replace_profile ();
+    if (p != NULL) {
+      p->in_use = true;
+      p->recording = true;
+      p->inumber = inumber;
+      p->page_cnt = 0;
+      t->exec_profile = p;
+      t->exec_start = timer_ticks ();
+    }
+  } else if (!p->recording) {
+    page_cnt = p->page_cnt;
+    memcpy (pages, p->pages, page_cnt * sizeof *pages);
+  }
+  if (p != NULL) {
+    p->last_used = timer_ticks ();
+  }
+
+  lock_release (&exec_profile_lock);
+
+  if (page_cnt > 0) {
+    qsort (pages, page_cnt, sizeof *pages, compare_pages);
+    exec_prefetch_pages += prefetch_file_pages (pages, page_cnt);
+    exec_prefetch_runs++;
+  }
+}
+
+void
+exec_profile_record (const void *uaddr) {
+  struct thread *t = thread_current ();
+  struct exec_profile *p = t->exec_profile;
+  if (p == NULL) {
+    return;
+  }
+
+  lock_acquire (&exec_profile_lock);
+
+  if (timer_elapsed (t->exec_start) > EXEC_PROFILE_TICKS) {
+    finish_recording (t);
+    lock_release (&exec_profile_lock);
+    return;
+  }
+
+  void *upage = pg_round_down (uaddr);
+  bool recorded = false;
+  for (size_t i = 0; i < p->page_cnt && !recorded; i++) {
+    recorded = p->pages[i] == upage;
+  }
+  if (!recorded && p->page_cnt < EXEC_PROFILE_PAGES) {
+    p->pages[p->page_cnt++] = upage;
+  }
+
+  lock_release (&exec_profile_lock);
+}
+
+void
+exec_profile_stop (struct thread *t) {
+  if (t->exec_profile == NULL) {
+    return;
+  }
+
+  lock_acquire (&exec_profile_lock);
+  finish_recording (t);
+  lock_release (&exec_profile_lock);
+}
+
+/*
+  Returns the profile of the executable with the given inode number, or
+  NULL if it has none
+*/
+static struct exec_profile *
+find_profile (block_sector_t inumber) {
+  for (size_t i = 0; i < EXEC_PROFILES; i++) {
+    if (profiles[i].in_use && profiles[i].inumber == inumber) {
+      return &profiles[i];
+    }
+  }
+  return NULL;
+}
+
+/*
+  Returns a free profile, or else the least recently used profile that
+  is not being recorded. Returns NULL if every profile is being recorded
+*/
+static struct exec_profile *
+replace_profile (void) {
+  struct exec_profile *victim = NULL;
+  for (size_t i = 0; i < EXEC_PROFILES; i++) {
+    struct exec_profile *p = &profiles[i];
+    if (!p->in_use) {
+      return p;
+    }
+    if (!p->recording && (victim == NULL || p->last_used < victim->last_used)) {
+      victim = p;
+    }
+  }
+  return victim;
+}
+
+/*
+  Ends the profile recorded by the thread. A profile with no pages is
+  dropped, so the next process started records it again
+*/
+static void
+finish_recording (struct thread *t) {
+  struct exec_profile *p = t->exec_profile;
+  p->recording = false;
+  if (p->page_cnt == 0) {
+    p->in_use = false;
+  } else {
+    exec_profiles_recorded++;
+  }
+  t->exec_profile = NULL;
+}
+
+/*
+  Orders user addresses for qsort
+*/
+static int
+compare_pages (const void *a, const void *b) {
+  uintptr_t page_a = (uintptr_t) *(void * const *) a;
+  uintptr_t page_b = (uintptr_t) *(void * const *) b;
+  return page_a < page_b ? -1 : page_a > page_b;
+}
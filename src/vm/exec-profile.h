@@ -0,0 +1,49 @@
+#ifndef VM_EXEC_PROFILE_H
+#define VM_EXEC_PROFILE_H
+
+#include "devices/timer.h"
+#include "filesys/file.h"
+#include "threads/thread.h"
+#include "userprog/exception.h"
+
+/* Number of executables whose profile is kept */
+#define EXEC_PROFILES (16)
+
+/* Maximum number of pages recorded in a profile */
+#define EXEC_PROFILE_PAGES (PREFETCH_MAX_PAGES)
+
+/* Ticks from the start of a process during which its faults are recorded */
+#define EXEC_PROFILE_TICKS (TIMER_FREQ / 10)
+
+/* Exec prefetch statistics */
+extern long long exec_profiles_recorded;   /* Profiles recorded */
+extern long long exec_prefetch_runs;       /* Processes started with a prefetch */
+extern long long exec_prefetch_pages;      /* Pages mapped by those prefetches */
+
+void exec_profile_init (void);
+
+/*
+  Called once a process has loaded its executable, before it first runs
+  in user mode. If the executable has a profile, the pages recorded in it
+  are prefetched in one batch sorted by address, so pages of the same
+  segment are read in file order. Otherwise a profile is recorded: the
+  pages of the executable the process faults on during its first
+  EXEC_PROFILE_TICKS, in fault order. Profiles are keyed by the inode
+  number of the executable, and the least recently used one is replaced
+  when all are taken
+*/
+void exec_profile_start (struct file *);
+
+/*
+  Records the fault of the current thread on a page read from its
+  executable, if it is recording a profile
+*/
+void exec_profile_record (const void *);
+
+/*
+  Ends the profile recorded by the thread, if there is one. Called when
+  the process exits
+*/
+void exec_profile_stop (struct thread *);
+
+#endif /* vm/exec-profile.h */
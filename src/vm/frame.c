@@ -9,25 +9,62 @@
 #include "userprog/syscall.h"
 #include "vm/swap.h"
 #include "userprog/pagedir.h"
+#include <round.h>
 #include <stdio.h>
+#include <string.h>
 #include "share-table.h"
-
-struct list frame_table;
+#include "vm/reclaim.h"
+#include "vm/region.h"
+#include "vm/stats.h"
+#include "vm/policy.h"
+#include "vm/page-cache.h"
+
+frame_table_entry *frame_table;
+size_t frame_table_size;
+size_t frame_table_used;
 struct lock frame_table_lock; 
 
-/* Pointer to the list elem for the current frame table entry
-   Used for the clock algorithm */
-struct list_elem *current_entry_elem;
+void *zero_page;
+
+size_t mlocked_pages;
 
-static bool check_page_access_bit (struct list *, frame_table_entry *);
-static struct list_elem *next_frame_table_elem (struct list_elem *e);
-static struct list_elem *prev_frame_table_elem (struct list_elem *e);
+/* Number of frames reclaimed when an allocation finds the user pool empty.
+   The frames not used by the allocation are left free for the next faults */
+#define EVICTION_REFILL (4)
+
+static bool check_page_access_bit (struct list *);
+static void wait_for_evictable_frame (void);
 
 void 
 init_frame_table (void) {
-  list_init (&frame_table);
   lock_init (&frame_table_lock);
-  current_entry_elem = list_head (&frame_table);
+
+  /* One entry for every page of the user pool, allocated up front */
+  frame_table_size = palloc_user_pages ();
+  size_t table_bytes = frame_table_size * sizeof (frame_table_entry);
+  size_t table_pages = DIV_ROUND_UP (table_bytes, PGSIZE);
+  frame_table = palloc_get_multiple (PAL_ASSERT | PAL_ZERO, table_pages);
+  frame_table_used = 0;
+  mlocked_pages = 0;
+  for (size_t i = 0; i < frame_table_size; i++) {
+    cond_init (&frame_table[i].io_done);
+  }
+  printf ("Frame table: %zu frames, %zu bytes in %zu pages.\n", 
+          frame_table_size, table_bytes, table_pages);
+
+  if (active_policy->init != NULL) {
+    active_policy->init ();
+  }
+  page_cache_init ();
+
+  zero_page = palloc_get_page (PAL_ASSERT | PAL_ZERO);
+}
+
+frame_table_entry *
+frame_from_kpage (void *kpage) {
+  size_t index = palloc_user_page_no (kpage);
+  ASSERT (index < frame_table_size);
+  return &frame_table[index];
 }
 
 /* 
@@ -36,19 +73,30 @@ init_frame_table (void) {
 */
 static frame_table_entry *
 create_frame (void *kpage, supp_pte *entry) {
-  frame_table_entry *new_frame = (frame_table_entry *) malloc (sizeof (frame_table_entry));
-  if (new_frame == NULL) {
-    return NULL;
-  }
+  frame_table_entry *new_frame = frame_from_kpage (kpage);
+  ASSERT (new_frame->kpage == NULL);
   
   new_frame->creator = entry;
   new_frame->kpage = kpage;
-  new_frame->r_bit = false;
-  new_frame->inode = file_get_inode (entry->file);
+  new_frame->last_use = entry->thread->virtual_time;
+  new_frame->prefetched = false;
+  new_frame->drop_behind = false;
+  new_frame->in_transit = false;
+  new_frame->inode = entry->file != NULL ? file_get_inode (entry->file) : NULL;
   new_frame->ofs = entry->ofs;
-  new_frame->can_be_shared = !(entry->writable) && (entry->page_source == DISK);
-
-  list_push_back (&frame_table, &new_frame->elem);
+  new_frame->read_bytes = entry->read_bytes;
+  new_frame->can_be_shared = false;
+  new_frame->copy_on_write = false;
+  new_frame->dirty_contents = false;
+  new_frame->checksum = 0;
+  new_frame->cached = false;
+  new_frame->holds_inode = false;
+  list_init (&new_frame->sharing_ptes);
+
+  frame_table_used++;
+  if (active_policy->frame_added != NULL) {
+    active_policy->frame_added (new_frame);
+  }
   return new_frame;
 }
 
@@ -57,23 +105,65 @@ try_allocate_page (enum palloc_flags flags, void *entry_ptr) {
   supp_pte *entry = (supp_pte *) entry_ptr;
   void *page = palloc_get_page (flags);
 
-  if (page) {
-    /* Successful allocation of frame - creates new frame table entry */
-    return create_frame (page, entry);
-  } else {
-    /* No frame is free, eviction required */
-    evict ();
+  while (page == NULL) {
+    /* No frame is free and the reclaim thread fell behind, eviction required */
+    if (evict (EVICTION_REFILL) == 0) {
+      wait_for_evictable_frame ();
+    }
     page = palloc_get_page (flags);
-    ASSERT (page != NULL);
-    return create_frame (page, entry);
   }
+
+  reclaim_wake ();
+  return create_frame (page, entry);
+}
+
+frame_table_entry *
+try_allocate_free_page (enum palloc_flags flags, void *entry_ptr) {
+  void *page = palloc_get_page (flags);
+  if (page == NULL) {
+    return NULL;
+  }
+  reclaim_wake ();
+
+  return create_frame (page, (supp_pte *) entry_ptr);
+}
+
+bool
+frame_is_shared (frame_table_entry *f) {
+  return f->can_be_shared || f->copy_on_write;
+}
+
+bool
+frame_is_mmapped (frame_table_entry *f) {
+  return !frame_is_shared (f) && ((supp_pte *) f->creator)->page_source == MMAP;
+}
+
+struct thread *
+frame_owner (frame_table_entry *f) {
+  if (frame_is_shared (f)) {
+    ASSERT (!list_empty (&f->sharing_ptes));
+    supp_pte *first = list_entry (list_front (&f->sharing_ptes), supp_pte, share_elem);
+    return first->thread;
+  }
+  return ((supp_pte *) f->creator)->thread;
+}
+
+/*
+  Returns true if the page of the entry holds data that cannot be recovered
+  from its file. Stack and anonymous pages have no backing file, so they
+  always do
+*/
+static bool
+page_is_dirty (supp_pte *entry) {
+  return entry->page_source == STACK || entry->page_source == ANON
+         || pagedir_is_dirty (entry->thread->pagedir, entry->uaddr);
 }
 
 /*
   Checks the accesses bits of the pages in the list of threads that share a frame
 */
 static bool
-check_page_access_bit (struct list *entries, frame_table_entry *hand) {
+check_page_access_bit (struct list *entries) {
   bool is_accessed = false;
   struct list_elem *e;
 
@@ -84,8 +174,6 @@ check_page_access_bit (struct list *entries, frame_table_entry *hand) {
     uint32_t *pd = sharing_thread->pagedir;
 
     if (pagedir_is_accessed (pd, entry->uaddr)) {
-      /* Set the reference bit to true because the page has been accessed */
-      hand->r_bit = true;
       is_accessed = true;
       pagedir_set_accessed (pd, entry->uaddr, false);
     }
@@ -94,12 +182,100 @@ check_page_access_bit (struct list *entries, frame_table_entry *hand) {
   return is_accessed;
 }
 
+/*
+  Checks and clears the accessed bits of every page mapped to the frame.
+  Returns true if any of them had been referenced since the last check
+*/
+static bool
+check_frame_access_bit (frame_table_entry *f) {
+  if (frame_is_shared (f)) {
+    return check_page_access_bit (&f->sharing_ptes);
+  }
+
+  supp_pte *entry = (supp_pte *) f->creator;
+  uint32_t *pd = entry->thread->pagedir;
+  if (pagedir_is_accessed (pd, entry->uaddr)) {
+    pagedir_set_accessed (pd, entry->uaddr, false);
+    return true;
+  }
+  return false;
+}
+
+bool
+frame_was_referenced (frame_table_entry *f) {
+  if (!check_frame_access_bit (f)) {
+    return false;
+  }
+  if (f->prefetched) {
+    f->prefetched = false;
+    swap_read_ahead_hit (((supp_pte *) f->creator)->thread);
+  }
+  return true;
+}
+
+/*
+  Returns true if the page of the entry sharing the copy-on-write frame
+  holds data that cannot be recovered from its file. A page forked from a
+  dirty page has a clean dirty bit of its own, which the frame makes up for
+*/
+static bool
+sharer_is_dirty (frame_table_entry *f, supp_pte *entry) {
+  return f->dirty_contents || page_is_dirty (entry);
+}
+
+bool
+frame_is_dirty (frame_table_entry *f) {
+  if (f->can_be_shared) {
+    return false;
+  }
+
+  if (f->copy_on_write) {
+    struct list_elem *e;
+    for (e = list_begin (&f->sharing_ptes); e != list_end (&f->sharing_ptes); e = list_next (e)) {
+      if (sharer_is_dirty (f, list_entry (e, supp_pte, share_elem))) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  return page_is_dirty ((supp_pte *) f->creator);
+}
+
+/*
+  Frees the page of the frame and marks its frame table entry as free
+*/
+static void
+release_frame (frame_table_entry *f) {
+  if (active_policy->frame_freed != NULL) {
+    active_policy->frame_freed (f);
+  }
+  palloc_free_page (f->kpage);
+  f->kpage = NULL;
+  frame_table_used--;
+}
+
+void
+clean_frame (frame_table_entry *f) {
+  write_back_page (f->creator);
+}
+
+void
+write_back_page (void *entry_ptr) {
+  supp_pte *entry = (supp_pte *) entry_ptr;
+  ASSERT (entry->page_source == MMAP && entry->page_frame != NULL);
+
+  file_write_at (entry->file, entry->page_frame->kpage, entry->read_bytes, entry->ofs);
+  pagedir_set_dirty (entry->thread->pagedir, entry->uaddr, false);
+  vm_stats.file_writebacks++;
+}
+
 /*
   Eviction for when the frame is shared between multiple threads - must clear for all
 */
 static void 
 evict_sharing_entries (share_entry *found_share_entry, frame_table_entry *f) {
-  struct list *entries = &found_share_entry->sharing_ptes;
+  struct list *entries = &f->sharing_ptes;
   struct list_elem *e;
   
   while (!list_empty (entries)) {
@@ -109,104 +285,361 @@ evict_sharing_entries (share_entry *found_share_entry, frame_table_entry *f) {
     entry->page_frame = NULL;
   }
 
-  if (&f->elem == current_entry_elem) {
-    current_entry_elem = prev_frame_table_elem (current_entry_elem);
-  }
-
+  page_cache_forget (f);
   hash_delete (&share_table, &found_share_entry->elem);
-  list_remove (&f->elem);
-
-  palloc_free_page (f->kpage);
-  free (f);
+  release_frame (f);
   free (found_share_entry);
 }
 
-/* Evicts page based on the clock page replacement algorithm */
 void
-evict (void) {
-  
-/* Exit loop once a page has been evicted */
-  bool evicted = false;
-  frame_table_entry *hand;
-  while (!evicted) {
-    current_entry_elem = next_frame_table_elem (current_entry_elem);
-    hand = list_entry (current_entry_elem, frame_table_entry, elem);
-
-    if (hand->can_be_shared) {
-      share_entry search;
-      search.frame = hand;
-
-      struct hash_elem *search_elem = hash_find (&share_table, &search.elem);
-      if (search_elem != NULL) {
-        share_entry *found_entry = hash_entry (search_elem, share_entry, elem);
-        if (!check_page_access_bit (&found_entry->sharing_ptes, hand)) {
-
-          if (hand->r_bit == false) {
-
-            /* Evict the first page without a set reference bit */
-            evict_sharing_entries (found_entry, hand);            
-            evicted = true;
-          } else {
-            hand->r_bit = false;
-          }
-        }
+free_cached_frame (frame_table_entry *f) {
+  ASSERT (f->cached);
+  evict_sharing_entries (find_share_entry (f), f);
+}
+
+/*
+  Maps the page of the entry to its frame again after the eviction of the
+  frame was given up, keeping the dirty bit the page had when it was unmapped.
+  Pages of a shared frame are mapped read-only, as when they were shared
+*/
+static void
+restore_page (supp_pte *entry, frame_table_entry *f) {
+  uint32_t *pd = entry->thread->pagedir;
+  bool dirty = pagedir_is_dirty (pd, entry->uaddr);
+  pagedir_set_page (pd, entry->uaddr, f->kpage, entry->writable && !frame_is_shared (f));
+  pagedir_set_dirty (pd, entry->uaddr, dirty);
+}
+
+/*
+  Eviction for a copy-on-write frame. Every sharer is unmapped before any 
+  data is written, then each sharer whose page cannot be recovered from its
+  file gets its own copy in swap space. Returns false if swap space is 
+  full, in which case the copies already made are released and every 
+  sharer is mapped to the frame again
+*/
+static bool
+evict_copy_on_write_frame (frame_table_entry *f) {
+  struct list *entries = &f->sharing_ptes;
+  struct list_elem *e;
+
+  for (e = list_begin (entries); e != list_end (entries); e = list_next (e)) {
+    supp_pte *entry = list_entry (e, supp_pte, share_elem);
+    pagedir_clear_page (entry->thread->pagedir, entry->uaddr);
+  }
+
+  for (e = list_begin (entries); e != list_end (entries); e = list_next (e)) {
+    supp_pte *entry = list_entry (e, supp_pte, share_elem);
+    if (sharer_is_dirty (f, entry)) {
+      entry->is_in_swap_space = true;
+      if (!load_page_into_swap_space (entry, f->kpage)) {
+        entry->is_in_swap_space = false;
+        break;
       }
-    } else {
-      supp_pte *to_be_evicted_entry = (supp_pte *) hand->creator;
-      
-      struct thread *eviction_thread = to_be_evicted_entry->thread;
-      uint32_t *pd = eviction_thread->pagedir;
-
-      if (pagedir_is_accessed (pd, to_be_evicted_entry->uaddr)) {
-        /* Set the reference bit to true because the page has been accessed */
-        hand->r_bit = true;
-        pagedir_set_accessed (pd, to_be_evicted_entry->uaddr, false);
-      } else {
-        if (hand->r_bit == false) {
-
-          /* Evict the first page without a set reference bit */
-          if (to_be_evicted_entry->page_source == MMAP) {
-            
-            struct list *mapped_list = &eviction_thread->mmapped_file_list;
-            struct list_elem *e;
-
-            for (e = list_begin (mapped_list); e != list_end (mapped_list); e = list_next (e)) {
-              mapped_file *map_entry = list_entry (e, mapped_file, mapped_elem);
-              if (map_entry->entry->page_frame->kpage == hand->kpage) { 
-
-                if (pagedir_is_dirty (pd, to_be_evicted_entry->uaddr)) {
-                  file_write_at (to_be_evicted_entry->file, to_be_evicted_entry->page_frame->kpage, to_be_evicted_entry->read_bytes, to_be_evicted_entry->ofs);
-                }
-
-                free_frame_from_supp_pte (&to_be_evicted_entry->elem, eviction_thread);
-                    
-                hash_delete (&eviction_thread->supp_page_table, &to_be_evicted_entry->elem);
-                free (to_be_evicted_entry);
-                    
-                list_remove (e);
-                free (map_entry);
-
-                break;
-              }
-            }
-          } else {
-            if (to_be_evicted_entry->page_source == STACK || pagedir_is_dirty (pd, hand->kpage)) {
-              /* Stack pages and dirty pages are written to swap space */
-              to_be_evicted_entry->is_in_swap_space = true;
-              load_page_into_swap_space (to_be_evicted_entry, hand->kpage);
-            }
-            /* Remove the evicted page from the frame table */
-            free_frame_from_supp_pte (&to_be_evicted_entry->elem, eviction_thread);
-          }
-
-          evicted = true;
-        } else {
-          hand->r_bit = false;
-          
-        }
+    }
+  }
+
+  if (e != list_end (entries)) {
+    for (e = list_begin (entries); e != list_end (entries); e = list_next (e)) {
+      supp_pte *entry = list_entry (e, supp_pte, share_elem);
+      if (entry->is_in_swap_space) {
+        release_swap_slot (entry);
+        entry->is_in_swap_space = false;
       }
+      restore_page (entry, f);
+    }
+    return false;
+  }
+
+  while (!list_empty (entries)) {
+    e = list_pop_front (entries);
+    list_entry (e, supp_pte, share_elem)->page_frame = NULL;
+  }
+
+  release_frame (f);
+  return true;
+}
+
+/*
+  Evicts the given frame, writing its contents to the memory mapped file or
+  to swap space if they cannot be recovered from the executable. Returns 
+  false if the frame had to be kept, as swap space is full or its memory
+  mapped page was dirtied after it was chosen and the file system lock is
+  not held
+*/
+static bool
+evict_frame (frame_table_entry *hand, bool files_writable) {
+  if (hand->can_be_shared) {
+    evict_sharing_entries (find_share_entry (hand), hand);
+    return true;
+  }
+
+  if (hand->copy_on_write) {
+    return evict_copy_on_write_frame (hand);
+  }
+
+  supp_pte *to_be_evicted_entry = (supp_pte *) hand->creator;
+  struct thread *eviction_thread = to_be_evicted_entry->thread;
+  uint32_t *pd = eviction_thread->pagedir;
+
+  if (to_be_evicted_entry->page_source == MMAP) {
+    /* 
+      The page is unmapped before it is written back, so writes made during
+      the write-back are not lost. The dirty bit survives the unmapping
+    */
+    pagedir_clear_page (pd, to_be_evicted_entry->uaddr);
+    if (pagedir_is_dirty (pd, to_be_evicted_entry->uaddr)) {
+      if (!files_writable) {
+        /* The frame was clean when chosen, its write-back is left to the reclaim thread */
+        restore_page (to_be_evicted_entry, hand);
+        reclaim_schedule_write (hand);
+        return false;
+      }
+      write_back_page (to_be_evicted_entry);
+    }
+
+    /* The entry stays in the mapping, so the page faults back in from the file */
+    free_frame_from_supp_pte (&to_be_evicted_entry->elem, eviction_thread);
+  } else {
+    /* Stack pages and dirty pages are written to swap space */
+    pagedir_clear_page (pd, to_be_evicted_entry->uaddr);
+    if (frame_is_dirty (hand)) {
+      to_be_evicted_entry->is_in_swap_space = true;
+      if (!load_page_into_swap_space (to_be_evicted_entry, hand->kpage)) {
+        /* Swap space is full, so the page stays in memory */
+        to_be_evicted_entry->is_in_swap_space = false;
+        restore_page (to_be_evicted_entry, hand);
+        return false;
+      }
+    }
+    /* Remove the evicted page from the frame table */
+    free_frame_from_supp_pte (&to_be_evicted_entry->elem, eviction_thread);
+  }
+  return true;
+}
+
+/*
+  Returns true if evicting the frame requires its contents to be written
+  to swap space
+*/
+static bool
+frame_needs_swap (frame_table_entry *f) {
+  return !frame_is_shared (f)
+         && !frame_is_mmapped (f)
+         && frame_is_dirty (f);
+}
+
+/*
+  Returns true if any page mapped to the frame is pinned
+*/
+static bool
+frame_is_pinned (frame_table_entry *f) {
+  if (!frame_is_shared (f)) {
+    return ((supp_pte *) f->creator)->pin_count > 0;
+  }
+
+  struct list_elem *e;
+  for (e = list_begin (&f->sharing_ptes); e != list_end (&f->sharing_ptes); e = list_next (e)) {
+    if (list_entry (e, supp_pte, share_elem)->pin_count > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+  Evicts the given victims. Frames that have to go to swap space are
+  unmapped first and then written out together as one clustered run
+  of swap sectors, the rest are evicted one by one. FILES_WRITABLE tells
+  whether the file system lock is held. Returns the number of frames
+  evicted
+*/
+static size_t
+evict_victims (frame_table_entry **victims, size_t victim_count, bool files_writable) {
+  supp_pte *swap_entries[EVICTION_BATCH_SIZE];
+  void *swap_pages[EVICTION_BATCH_SIZE];
+  size_t swap_count = 0;
+  size_t evicted = 0;
+
+  for (size_t i = 0; i < victim_count; i++) {
+    frame_table_entry *victim = victims[i];
+
+    if (victim->prefetched) {
+      swap_read_ahead_miss (((supp_pte *) victim->creator)->thread);
+    }
+
+    if (frame_needs_swap (victim)) {
+      supp_pte *entry = (supp_pte *) victim->creator;
+
+      /* Stop the owner modifying the page while it is being written */
+      pagedir_clear_page (entry->thread->pagedir, entry->uaddr);
+      entry->is_in_swap_space = true;
+
+      swap_entries[swap_count] = entry;
+      swap_pages[swap_count] = victim->kpage;
+      swap_count++;
+    } else if (evict_frame (victim, files_writable)) {
+      evicted++;
+    }
+  }
+
+  if (swap_count > 0) {
+    load_pages_into_swap_space (swap_entries, swap_pages, swap_count);
+  }
+
+  /* 
+    A frame is freed if its page went to the swap cache or to BLOCK_SWAP.
+    Pages left out as swap space filled up stay in memory
+  */
+  for (size_t i = 0; i < swap_count; i++) {
+    supp_pte *entry = swap_entries[i];
+    if (entry->is_in_swap_space) {
+      free_frame_from_supp_pte (&entry->elem, entry->thread);
+      evicted++;
+    } else {
+      restore_page (entry, entry->page_frame);
+    }
+  }
+  return evicted;
+}
+
+size_t
+evict (size_t count) {
+  ASSERT (frame_table_used > 0);
+  ASSERT (count > 0);
+
+  if (count > EVICTION_BATCH_SIZE) {
+    count = EVICTION_BATCH_SIZE;
+  }
+
+  /*
+    Dirty memory mapped frames can only be chosen if the file system lock
+    can be had without waiting for it, as its holder may be waiting for
+    the table locks
+  */
+  bool files_acquired = false;
+  bool files_writable = lock_held_by_current_thread (&file_system_lock);
+  if (!files_writable) {
+    files_acquired = files_writable = lock_try_acquire (&file_system_lock);
+  }
+
+  /*
+    Frames of the page cache are mapped by no page, so they are reclaimed
+    before the policy is asked for any mapped frame. Freeing them closes 
+    their inode, which needs the file system lock
+  */
+  frame_table_entry *victims[EVICTION_BATCH_SIZE];
+  size_t victim_count = 0;
+  if (files_writable) {
+    victim_count = page_cache_reclaim (victims, count);
+  }
+
+  if (victim_count == 0) {
+    if (active_policy->scan_accessed != NULL) {
+      active_policy->scan_accessed ();
+    }
+    victim_count = active_policy->choose_victims (victims, count, files_writable);
+  }
+  ASSERT (victim_count <= count);
+
+  size_t evicted = evict_victims (victims, victim_count, files_writable);
+  vm_stats.evictions += evicted;
+
+  if (files_acquired) {
+    lock_release (&file_system_lock);
+  }
+  return evicted;
+}
+
+size_t
+evict_thread_frames (struct thread *t) {
+  ASSERT (lock_held_by_current_thread (&file_system_lock));
+
+  frame_table_entry *victims[EVICTION_BATCH_SIZE];
+  size_t victim_count = 0;
+  size_t evicted = 0;
+
+  /* Evicting frames frees no entries, so the table can be walked throughout */
+  struct hash_iterator i;
+  hash_first (&i, &t->supp_page_table);
+  while (hash_next (&i)) {
+    supp_pte *entry = hash_entry (hash_cur (&i), supp_pte, elem);
+    frame_table_entry *f = entry->page_frame;
+    if (f == NULL || frame_is_shared (f) || !frame_can_be_evicted (f, true)) {
+      continue;
+    }
+
+    victims[victim_count++] = f;
+    if (victim_count == EVICTION_BATCH_SIZE) {
+      evicted += evict_victims (victims, victim_count, true);
+      victim_count = 0;
     }
+  }
+
+  if (victim_count > 0) {
+    evicted += evict_victims (victims, victim_count, true);
+  }
+  vm_stats.evictions += evicted;
+  return evicted;
+}
+
+bool
+frame_can_be_evicted (frame_table_entry *f, bool files_writable) {
+  if (f->kpage == NULL || f->in_transit || frame_is_pinned (f)) {
+    return false;
+  }
+  if (files_writable) {
+    return true;
+  }
+  return !f->holds_inode && (!frame_is_mmapped (f) || !frame_is_dirty (f));
+}
 
+/*
+  Removes the supplemental page table entry from the copy-on-write frame it
+  shares. If a single entry is left sharing the frame, the frame becomes 
+  private to that entry and its page is made writable again
+*/
+static void
+leave_copy_on_write_frame (supp_pte *entry) {
+  frame_table_entry *f = entry->page_frame;
+  ASSERT (f->copy_on_write);
+
+  pagedir_clear_page (entry->thread->pagedir, entry->uaddr);
+  list_remove (&entry->share_elem);
+  entry->page_frame = NULL;
+
+  if (list_size (&f->sharing_ptes) == 1) {
+    supp_pte *owner = list_entry (list_pop_front (&f->sharing_ptes), supp_pte, share_elem);
+    if (f->dirty_contents) {
+      /* Once private, the dirty bit of the page alone tells whether it must go to swap */
+      pagedir_set_dirty (owner->thread->pagedir, owner->uaddr, true);
+      f->dirty_contents = false;
+    }
+    f->copy_on_write = false;
+    f->creator = owner;
+    pagedir_set_writable (owner->thread->pagedir, owner->uaddr, owner->writable);
+  }
+}
+
+/*
+  Removes the supplemental page table entry from the share table frame it
+  shares. A frame left with no sharers is kept in the page cache if 
+  possible, otherwise it is removed from the share table and freed
+*/
+static void
+leave_shared_frame (supp_pte *entry) {
+  frame_table_entry *f = entry->page_frame;
+  ASSERT (f->can_be_shared);
+
+  pagedir_clear_page (entry->thread->pagedir, entry->uaddr);
+  share_entry *found_share_entry = find_share_entry (f);
+  list_remove (&entry->share_elem); 
+  entry->page_frame = NULL;
+
+  if (list_empty (&f->sharing_ptes) && !page_cache_keep (f)) {
+    struct hash_elem *deleted = hash_delete (&share_table, &found_share_entry->elem);
+    ASSERT(deleted);
+    free (found_share_entry);
+    release_frame (f);
   }
 }
 
@@ -219,59 +652,227 @@ free_frame_from_supp_pte (struct hash_elem *e, void *aux) {
 
   if (f != NULL) {
     if (f->can_be_shared) {
-      share_entry search_entry;
-      search_entry.frame = f;
-
-      struct hash_elem *search_elem = hash_find (&share_table, &search_entry.elem);
-      share_entry *found_share_entry = hash_entry (search_elem, share_entry, elem);
-      list_remove (&entry->share_elem); 
-
-      if (list_empty (&found_share_entry->sharing_ptes)) {
-        if (&f->elem == current_entry_elem) {
-          current_entry_elem = prev_frame_table_elem (current_entry_elem);
-        }
-        struct hash_elem *deleted = hash_delete (&share_table, &found_share_entry->elem);
-        list_remove (&f->elem);
-        entry->page_frame = NULL;
-        palloc_free_page (f->kpage);
-        free (f);
-        ASSERT(deleted);
-        free (found_share_entry);
-      }
+      leave_shared_frame (entry);
+    } else if (f->copy_on_write) {
+      leave_copy_on_write_frame (entry);
     } else {
-      if (&f->elem == current_entry_elem) {
-        current_entry_elem = prev_frame_table_elem (current_entry_elem);
-      }
-      list_remove (&f->elem);
       entry->page_frame = NULL;
-      palloc_free_page (f->kpage);
-      free (f);
+      release_frame (f);
     }
     
   }
 
 }
 
-/*
-  Returns the next element for a frame table entry, looping around from
-  the end to the start of the list
-*/
-static struct list_elem *
-next_frame_table_elem (struct list_elem *e) {
-  struct list_elem *next = list_next (e);
-  if (next == list_end (&frame_table)) {
-    next = list_begin (&frame_table);
+bool
+share_frame_copy_on_write (void *owner_ptr, void *sharer_ptr) {
+  supp_pte *owner = (supp_pte *) owner_ptr;
+  supp_pte *sharer = (supp_pte *) sharer_ptr;
+  frame_table_entry *f = owner->page_frame;
+  ASSERT (f != NULL && !f->can_be_shared);
+
+  /* The sharer's page must be written to swap if the owner's had to be */
+  if (page_is_dirty (owner)) {
+    f->dirty_contents = true;
+  }
+
+  if (!f->copy_on_write) {
+    /* Turn the private frame into a copy-on-write one */
+    f->copy_on_write = true;
+    f->prefetched = false;
+    f->creator = NULL;
+    list_push_back (&f->sharing_ptes, &owner->share_elem);
+    pagedir_set_writable (owner->thread->pagedir, owner->uaddr, false);
+  }
+
+  sharer->page_frame = f;
+  list_push_back (&f->sharing_ptes, &sharer->share_elem);
+
+  if (!pagedir_set_page (sharer->thread->pagedir, sharer->uaddr, f->kpage, false)) {
+    leave_copy_on_write_frame (sharer);
+    return false;
+  }
+  return true;
+}
+
+bool
+break_copy_on_write (void *entry_ptr) {
+  supp_pte *entry = (supp_pte *) entry_ptr;
+  frame_table_entry *f = entry->page_frame;
+
+  if (f == NULL || !frame_is_shared (f)) {
+    /* 
+      The frame was evicted or its other sharers left it while waiting for
+      the table locks. Retrying the access will fault in or write the page
+    */
+    return true;
+  }
+
+  /*
+    Copy the page aside before leaving the frame, so allocating the new
+    frame is free to evict the shared one
+  */
+  void *copy = palloc_get_page (0);
+  if (copy == NULL) {
+    return false;
+  }
+  memcpy (copy, f->kpage, PGSIZE);
+  if (f->can_be_shared) {
+    /* A writable page of the executable shared through the share table */
+    leave_shared_frame (entry);
+  } else {
+    leave_copy_on_write_frame (entry);
+  }
+
+  frame_table_entry *new_frame = try_allocate_page (PAL_USER, entry);
+  memcpy (new_frame->kpage, copy, PGSIZE);
+  palloc_free_page (copy);
+
+  entry->page_frame = new_frame;
+  if (!pagedir_set_page (entry->thread->pagedir, entry->uaddr, new_frame->kpage, true)) {
+    free_frame_from_supp_pte (&entry->elem, entry->thread);
+    return false;
+  }
+  return true;
+}
+
+bool
+frame_can_be_merged (frame_table_entry *f) {
+  if (f->kpage == NULL || f->in_transit || f->can_be_shared || f->drop_behind || frame_is_pinned (f)) {
+    return false;
   }
-  return next;
+  if (f->copy_on_write) {
+    /* Only pages that are not memory mapped are shared copy-on-write */
+    return true;
+  }
+  supp_pte *entry = (supp_pte *) f->creator;
+  return entry->writable && entry->page_source != MMAP;
+}
+
+bool
+merge_frames (frame_table_entry *keep, frame_table_entry *dup) {
+  ASSERT (keep != dup && !dup->copy_on_write);
+
+  supp_pte *dup_entry = (supp_pte *) dup->creator;
+  uint32_t *dup_pd = dup_entry->thread->pagedir;
+  supp_pte *keep_entry = keep->copy_on_write 
+                         ? list_entry (list_front (&keep->sharing_ptes), supp_pte, share_elem)
+                         : (supp_pte *) keep->creator;
+
+  /* 
+    The pages are write protected before they are compared, so neither can
+    change afterwards. Copy-on-write pages already are
+  */
+  pagedir_set_writable (dup_pd, dup_entry->uaddr, false);
+  if (!keep->copy_on_write) {
+    pagedir_set_writable (keep_entry->thread->pagedir, keep_entry->uaddr, false);
+  }
+
+  if (memcmp (keep->kpage, dup->kpage, PGSIZE) != 0) {
+    pagedir_set_writable (dup_pd, dup_entry->uaddr, true);
+    if (!keep->copy_on_write) {
+      pagedir_set_writable (keep_entry->thread->pagedir, keep_entry->uaddr, true);
+    }
+    return false;
+  }
+
+  /* 
+    The pages may come from different files, so each keeps its own record
+    of whether it can be recovered from its file. The duplicate is not
+    forked from the kept page, so the state of the frame is left as it was
+  */
+  bool dup_dirty = page_is_dirty (dup_entry);
+  bool dirty_contents = keep->dirty_contents;
+  pagedir_clear_page (dup_pd, dup_entry->uaddr);
+  dup_entry->page_frame = NULL;
+
+  /* Mapping the shared frame cannot fail, as the page table of the page exists */
+  bool shared = share_frame_copy_on_write (keep_entry, dup_entry);
+  ASSERT (shared);
+  keep->dirty_contents = dirty_contents;
+  if (dup_dirty) {
+    pagedir_set_dirty (dup_pd, dup_entry->uaddr, true);
+  }
+
+  release_frame (dup);
+  return true;
+}
+
+void *
+pin_page (struct thread *t, const void *uaddr) {
+  lock_tables ();
+  supp_pte *entry = get_supp_pte (t, uaddr);
+  if (entry != NULL) {
+    entry->pin_count++;
+  }
+  release_tables ();
+  return entry;
+}
+
+void
+unpin_page (void *entry_ptr) {
+  supp_pte *entry = (supp_pte *) entry_ptr;
+  lock_tables ();
+  ASSERT (entry->pin_count > 0);
+  entry->pin_count--;
+  release_tables ();
+}
+
+void
+release_page_lock (void *entry_ptr) {
+  supp_pte *entry = (supp_pte *) entry_ptr;
+  if (!entry->mlocked) {
+    return;
+  }
+
+  entry->mlocked = false;
+  entry->pin_count--;
+  entry->thread->mlocked_pages--;
+  mlocked_pages--;
 }
 
 /*
-  Returns the prev element for a frame table entry
+  Called with the table locks held when no frame can be evicted: every
+  frame is in transit, pinned, or needs the file system lock held by
+  another thread, which may itself be waiting for the table locks.
+  Releases the table locks so those threads can get on, waits for the
+  file system lock to be free if it is not held by the current thread,
+  and takes the table locks again
 */
-static struct list_elem *
-prev_frame_table_elem (struct list_elem *e) {
-  struct list_elem *prev = list_prev (e);
-  return prev;
+static void
+wait_for_evictable_frame (void) {
+  release_tables ();
+  if (lock_held_by_current_thread (&file_system_lock)) {
+    thread_yield ();
+  } else {
+    lock_acquire (&file_system_lock);
+    lock_release (&file_system_lock);
+  }
+  lock_tables ();
+}
+
+void
+begin_frame_io (frame_table_entry *f) {
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  f->in_transit = true;
+}
+
+void
+end_frame_io (frame_table_entry *f) {
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  f->in_transit = false;
+  cond_broadcast (&f->io_done, &frame_table_lock);
+}
+
+void
+wait_for_frame_io (frame_table_entry *f) {
+  /* The share table lock is taken after the frame table lock, so it is 
+     released first and taken again once woken */
+  while (f->in_transit) {
+    lock_release (&share_table_lock);
+    cond_wait (&f->io_done, &frame_table_lock);
+    lock_acquire (&share_table_lock);
+  }
 }
 
 void
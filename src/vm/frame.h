@@ -9,12 +9,6 @@
 #include "filesys/off_t.h"
 #include "debug.h"
 
-/*
-  Global list to track the pages which are occupied
-*/
-extern struct list frame_table;
-
-
 /*
   Global lock to ensure synchronized access to the frame table
 */
@@ -24,20 +18,71 @@ extern struct lock frame_table_lock;
   Struct to store an entry in the frame table 
 */
 typedef struct {
-  void *kpage;              /* The kernel page where data is stored */                
-  struct list_elem elem;    /* Elem to insert into frame table */
+  void *kpage;              /* The kernel page where data is stored. NULL if the entry is free */                
 
   struct inode *inode;      /* Inode to find a share table entry */
   off_t ofs;                /* Offset to find a share table entry */
+  uint32_t read_bytes;      /* Bytes read from the file to find a share table entry */
+
+  int64_t last_use;         /* Owner's virtual time when the frame was last seen referenced */
+  bool prefetched;          /* Read ahead from swap and not yet seen accessed */
+  bool drop_behind;         /* Left behind by sequential access, so evicted before other frames */
+
+  /* Information kept by the eviction policies, see vm/policy.h */
+  uint8_t age;              /* LRU aging counter, shifted right on every scan */
+  uint8_t queue;            /* 2Q queue holding the frame, if any */
+  struct list_elem queue_elem; /* List elem - each 2Q queue is a list of frames */
 
-  bool r_bit;               /* Reference bit */
+  /* Information needed for device I/O into the frame */
+  bool in_transit;          /* Records whether the frame is being filled. It is not mapped
+                               or evicted until the I/O is done */
+  struct condition io_done; /* Signalled when the I/O into the frame is done */
+
+  unsigned checksum;        /* Checksum of the contents when the merge scanner last saw the frame */
 
   /* Information needed for sharing */
   bool can_be_shared;       /* Records whether the frame is sharable */
+  bool copy_on_write;       /* Records whether writable pages share the frame until one writes to it */
+  bool dirty_contents;      /* Records whether a dirty page was forked into the copy-on-write frame, so
+                               the pages forked from it cannot be recovered from their file either */
   void *creator;            /* Points to supp_pte that created the frame. Unused for shared frame */
+  struct list sharing_ptes; /* Supplemental page table entries sharing the frame. Unused for private frame */
+
+  /* Information kept by the page cache, see vm/page-cache.h */
+  bool cached;              /* Records whether the frame is kept in the share table with no sharers */
+  bool holds_inode;         /* Records whether the frame holds a reference to its inode */
+  struct list_elem cache_elem; /* List elem - for the list of cached frames */
 
 } frame_table_entry;
 
+/*
+  Global frame table - a contiguous array with one entry per page of the
+  user pool, indexed by the position of the page in the pool
+*/
+extern frame_table_entry *frame_table;
+
+/* Number of entries in the frame table */
+extern size_t frame_table_size;
+
+/* Number of entries in the frame table that hold a page */
+extern size_t frame_table_used;
+
+
+/*
+  Page of zeros mapped read-only into zero-filled pages that have only been
+  read, so they do not need a frame until they are first written to.
+  It is allocated from the kernel pool and is not part of the frame table
+*/
+extern void *zero_page;
+
+/* Maximum number of pages a process can lock in memory with mlock */
+#define MLOCK_QUOTA_PAGES (64)
+
+/* Maximum number of pages locked with mlock across all processes */
+#define MLOCK_LIMIT_PAGES (frame_table_size / 2)
+
+/* Number of pages locked with mlock across all processes */
+extern size_t mlocked_pages;
 
 /*
   Initialises a frame table
@@ -45,21 +90,178 @@ typedef struct {
 void init_frame_table (void);
 
 
+/*
+  Returns the frame table entry for the given page of the user pool
+*/
+frame_table_entry *frame_from_kpage (void *);
+
 /*
   Tries to allocate a page of memory using the flags provided
   Returns the pointer to page frame if successful, otherwise NULL
 */
 frame_table_entry *try_allocate_page (enum palloc_flags flags, void *entry);
 
-/* Evicts page based on the clock algorithm */
-void evict (void);
+/*
+  Allocates a page of memory using the flags provided only if one is free,
+  never evicting. Used for speculative loads.
+  Returns the pointer to page frame if successful, otherwise NULL
+*/
+frame_table_entry *try_allocate_free_page (enum palloc_flags flags, void *entry);
+
+/* Maximum number of frames that can be evicted by a single call to evict */
+#define EVICTION_BATCH_SIZE (16)
+
+/* 
+  Evicts up to the given number of pages chosen by the eviction policy,
+  returning how many were evicted. Returns 0 if no frame can be evicted
+  at the moment, in which case the caller must release the table locks
+  and wait before trying again
+*/
+size_t evict (size_t);
+
+/*
+  Evicts every private frame of the thread that can be evicted, returning
+  how many were evicted. The file system lock and the table locks must be held
+*/
+size_t evict_thread_frames (struct thread *);
+
+/*
+  The following functions are used by the eviction policies
+*/
+
+/*
+  Returns true if the frame is mapped by the entries in its sharing list
+  rather than by its creator alone
+*/
+bool frame_is_shared (frame_table_entry *);
+
+/*
+  Returns true if the frame privately holds a page of a memory mapped file
+*/
+bool frame_is_mmapped (frame_table_entry *);
+
+/*
+  Returns the thread whose virtual time is used to age the frame.
+  Shared frames are aged by the first thread that shares them
+*/
+struct thread *frame_owner (frame_table_entry *);
+
+/*
+  Returns true if the frame holds data that has to be written somewhere
+  before the frame can be reused.
+  Share table frames are copies of the executable mapped read-only, so
+  they are always clean. Copy-on-write frames are dirty if any sharer's page is
+*/
+bool frame_is_dirty (frame_table_entry *);
+
+/*
+  Checks and clears the accessed bits of every page mapped to the frame.
+  Returns true if any of them had been referenced since the last check,
+  counting a hit for a frame read ahead from swap
+*/
+bool frame_was_referenced (frame_table_entry *);
+
+/*
+  Returns true if the frame holds a page that can be evicted now. Free,
+  pinned and in transit frames cannot be, nor can dirty memory mapped 
+  frames and frames holding a reference to their inode unless the boolean
+  is true, as they need the file system
+*/
+bool frame_can_be_evicted (frame_table_entry *, bool);
+
+/*
+  Writes a dirty memory mapped frame back to its file without evicting it,
+  so the frame becomes a clean candidate for eviction
+*/
+void clean_frame (frame_table_entry *);
+
+/*
+  Writes the resident memory mapped page of the supplemental page table
+  entry back to its file, clears its dirty bit and counts the write-back.
+  Every write-back of a mapped page goes through here. The file system
+  lock and the table locks must be held
+*/
+void write_back_page (void *);
 
 /*
   Frees the given page in a thread's supplemental page table 
-  and its corresponding frame table entry
+  and its corresponding frame table entry. A share table frame left with
+  no sharers is kept in the page cache if possible
 */
 void free_frame_from_supp_pte (struct hash_elem *, void *);
 
+/*
+  Frees a frame of the page cache, removing it from the share table.
+  The file system lock and the table locks must be held
+*/
+void free_cached_frame (frame_table_entry *);
+
+/*
+  Shares the resident frame of the first supplemental page table entry 
+  copy-on-write with the second entry, which has no frame. Both pages are
+  mapped read-only until one of them is written to
+*/
+bool share_frame_copy_on_write (void *, void *);
+
+/*
+  Gives the supplemental page table entry a private copy of the
+  copy-on-write or share table frame it shares, mapped writable.
+  Returns true if successful
+*/
+bool break_copy_on_write (void *);
+
+/*
+  Returns true if the frame may be merged with identical frames by the
+  merge scanner: a resident, unpinned frame of writable pages that are
+  not memory mapped
+*/
+bool frame_can_be_merged (frame_table_entry *);
+
+/*
+  Merges the private frame DUP into the frame KEEP if their contents are
+  identical, so the page of DUP shares KEEP copy-on-write and DUP is freed.
+  Both frames must be accepted by frame_can_be_merged. Returns true if 
+  the frames were merged. The table locks must be held
+*/
+bool merge_frames (frame_table_entry *keep, frame_table_entry *dup);
+
+/*
+  Pins the page of the thread containing the address, so its frame is not
+  evicted while it is resident. Returns the supplemental page table entry
+  of the page, or NULL if the address has no page
+*/
+void *pin_page (struct thread *, const void *);
+
+/*
+  Removes a pin from the supplemental page table entry
+*/
+void unpin_page (void *);
+
+/*
+  Clears the mlock of the supplemental page table entry, if it has one,
+  removing its pin and returning it to the quotas. The table locks must be held
+*/
+void release_page_lock (void *);
+
+/*
+  Marks the frame as in transit while its page is read in with the table
+  locks released. The frame table lock must be held
+*/
+void begin_frame_io (frame_table_entry *);
+
+/*
+  Marks the I/O into the frame as done and wakes the threads waiting for it.
+  The frame table lock must be held
+*/
+void end_frame_io (frame_table_entry *);
+
+/*
+  Waits for the I/O into the frame to be done. The table locks must be held,
+  and are released while waiting. The frame may have been freed or reused
+  by the time this returns
+*/
+void wait_for_frame_io (frame_table_entry *);
+
 /*  
   Frame table and share table lock needs to be acquired and released at the same time
   The following functions are used to enforce this.
@@ -0,0 +1,136 @@
+#include "vm/ksm.h"
+#include <debug.h>
+#include <hash.h>
+#include <round.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/frame.h"
+
+bool ksm_enabled;
+
+long long ksm_frames_merged;
+long long ksm_full_scans;
+
+/*
+  Slot of the index of the stable frames seen in the current walk of the 
+  frame table, an open addressing hash table keyed by checksum
+*/
+struct stable_slot {
+  unsigned checksum;          /* Checksum of the frame when it was indexed */
+  size_t frame;               /* Index of the frame in the frame table plus one, 0 if empty */
+};
+
+static struct stable_slot *stable_index;
+static size_t stable_index_size;        /* Number of slots, a power of two */
+static size_t stable_index_pages;
+
+/* Index of the next frame table entry the scanner examines */
+static size_t scan_cursor;
+
+static thread_func ksm_thread NO_RETURN;
+
+void
+ksm_init (void) {
+  if (!ksm_enabled) {
+    return;
+  }
+
+  /* At least twice as many slots as frames, so probe sequences stay short */
+  stable_index_size = 1;
+  while (stable_index_size < 2 * frame_table_size) {
+    stable_index_size *= 2;
+  }
+  stable_index_pages = DIV_ROUND_UP (stable_index_size * sizeof *stable_index, PGSIZE);
+  stable_index = palloc_get_multiple (PAL_ZERO, stable_index_pages);
+  if (stable_index == NULL) {
+    ksm_enabled = false;
+    return;
+  }
+  scan_cursor = 0;
+
+  thread_create ("ksm", PRI_DEFAULT, ksm_thread, NULL);
+}
+
+/*
+  Merges the stable frame F with an identical frame of the same CHECKSUM
+  in the index. Returns true if F was merged and freed
+*/
+static bool
+merge_with_stable (frame_table_entry *f, unsigned checksum) {
+  size_t mask = stable_index_size - 1;
+  for (size_t i = checksum & mask; stable_index[i].frame != 0; i = (i + 1) & mask) {
+    if (stable_index[i].checksum != checksum) {
+      continue;
+    }
+
+    /* The indexed frame may have been changed or freed since */
+    frame_table_entry *keep = &frame_table[stable_index[i].frame - 1];
+    if (keep != f && keep->checksum == checksum && frame_can_be_merged (keep)
+        && merge_frames (keep, f)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+  Adds the stable frame F to the index under its CHECKSUM
+*/
+static void
+index_stable (frame_table_entry *f, unsigned checksum) {
+  size_t mask = stable_index_size - 1;
+  size_t i = checksum & mask;
+  while (stable_index[i].frame != 0) {
+    i = (i + 1) & mask;
+  }
+  stable_index[i].checksum = checksum;
+  stable_index[i].frame = (f - frame_table) + 1;
+}
+
+/*
+  Examines the next KSM_FRAMES_PER_PASS frame table entries. The index
+  is cleared whenever the walk of the table starts over, so every frame
+  is indexed at most once
+*/
+static void
+scan_frames (void) {
+  lock_tables ();
+
+  for (size_t n = 0; n < KSM_FRAMES_PER_PASS; n++) {
+    frame_table_entry *f = &frame_table[scan_cursor];
+    scan_cursor = (scan_cursor + 1) % frame_table_size;
+    if (scan_cursor == 0) {
+      memset (stable_index, 0, stable_index_size * sizeof *stable_index);
+      ksm_full_scans++;
+    }
+
+    if (!frame_can_be_merged (f)) {
+      continue;
+    }
+
+    unsigned checksum = hash_bytes (f->kpage, PGSIZE);
+    if (checksum != f->checksum) {
+      /* Changed since the last walk, so not worth merging yet */
+      f->checksum = checksum;
+      continue;
+    }
+
+    if (!f->copy_on_write && merge_with_stable (f, checksum)) {
+      ksm_frames_merged++;
+      continue;
+    }
+    index_stable (f, checksum);
+  }
+
+  release_tables ();
+}
+
+static void
+ksm_thread (void *aux UNUSED) {
+  for (;;) {
+    timer_sleep (KSM_PERIOD);
+    scan_frames ();
+  }
+}
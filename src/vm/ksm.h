@@ -0,0 +1,31 @@
+#ifndef VM_KSM_H
+#define VM_KSM_H
+
+#include <stdbool.h>
+#include "devices/timer.h"
+
+/* Ticks between passes of the merge scanner */
+#define KSM_PERIOD (TIMER_FREQ / 10)
+
+/* Number of frame table entries examined in one pass */
+#define KSM_FRAMES_PER_PASS (32)
+
+/* Records whether the merge scanner runs, set with -vm-ksm on the kernel command line */
+extern bool ksm_enabled;
+
+/* Merge scanner statistics */
+extern long long ksm_frames_merged;        /* Frames freed by merging them with identical ones */
+extern long long ksm_full_scans;           /* Passes of the scanner over the whole frame table */
+
+/*
+  Starts the merge scanner if it is enabled. The scanner walks the frame
+  table a few frames at a time, checksumming the contents of the frames
+  of writable pages that are not memory mapped. A frame whose checksum
+  did not change since the scanner last saw it is stable: it is merged 
+  with a stable frame of the same checksum and contents seen earlier in 
+  the same walk of the table, if there is one. Merged pages share one
+  frame copy-on-write, so a write to any of them gives it its own copy again
+*/
+void ksm_init (void);
+
+#endif /* vm/ksm.h */
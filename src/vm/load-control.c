@@ -0,0 +1,134 @@
+#include "vm/load-control.h"
+#include <debug.h>
+#include <list.h>
+#include "devices/block.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+#include "vm/page-cache.h"
+#include "vm/reclaim.h"
+
+long long load_control_suspensions;
+long long load_control_resumptions;
+
+/* 
+  Processes suspended by load control, longest suspended first.
+  Protected by disabling interrupts
+*/
+static struct list suspended_list;
+
+/* Totals of one sample of the processes */
+struct load_sample {
+  int faults;                 /* Major faults of every process in the period */
+  int active;                 /* Processes neither suspended nor waiting for a child */
+  bool requested;             /* Records if a suspension is still pending */
+  struct thread *victim;      /* Active process with the highest fault rate */
+};
+
+static thread_func load_control_thread NO_RETURN;
+static void sample_process (struct thread *, void *);
+
+void
+load_control_init (void) {
+  list_init (&suspended_list);
+
+  /* Suspended processes can only give up their dirty pages to swap space */
+  if (block_get_role (BLOCK_SWAP) == NULL) {
+    return;
+  }
+  thread_create ("load-control", PRI_DEFAULT, load_control_thread, NULL);
+}
+
+void
+load_control_safe_point (void) {
+  struct thread *t = thread_current ();
+  if (!t->suspend_requested) {
+    return;
+  }
+
+  /* The resident set goes first, so the remaining processes can use it */
+  lock_acquire (&file_system_lock);
+  lock_tables ();
+  evict_thread_frames (t);
+  release_tables ();
+  lock_release (&file_system_lock);
+
+  enum intr_level old_level = intr_disable ();
+  t->suspend_requested = false;
+  t->suspended = true;
+  t->suspended_at = timer_ticks ();
+  list_push_back (&suspended_list, &t->suspend_elem);
+  load_control_suspensions++;
+  intr_set_level (old_level);
+
+  sema_down (&t->resume_sema);
+}
+
+/*
+  Updates the fault rate estimate of a user process, adding it to the 
+  sample. Called with interrupts off
+*/
+static void
+sample_process (struct thread *t, void *aux) {
+  struct load_sample *sample = aux;
+  if (t->pagedir == NULL) {
+    return;
+  }
+
+  t->fault_rate = (t->fault_rate + t->major_faults) / 2;
+  sample->faults += t->major_faults;
+  t->major_faults = 0;
+
+  if (t->suspended || t->waiting_for_child) {
+    return;
+  }
+  sample->active++;
+  if (t->suspend_requested) {
+    sample->requested = true;
+  }
+  if (sample->victim == NULL || t->fault_rate > sample->victim->fault_rate) {
+    sample->victim = t;
+  }
+}
+
+/*
+  Samples the processes every period, suspending one while the system 
+  thrashes and resuming one when the fault rate has dropped. Resuming
+  does not wait for free pages, as nothing may reclaim any once the 
+  faults have stopped
+*/
+static void
+load_control_thread (void *aux UNUSED) {
+  for (;;) {
+    timer_sleep (LOAD_CONTROL_PERIOD);
+    /* Frames of the page cache are reclaimed before any mapped page, so they count as free */
+    size_t free_pages = palloc_user_free_pages () + page_cache_pages;
+
+    struct load_sample sample = { 0, 0, false, NULL };
+    enum intr_level old_level = intr_disable ();
+    thread_foreach (sample_process, &sample);
+
+    bool thrashing = sample.faults >= LOAD_CONTROL_THRASHING_FAULTS
+                     && free_pages < reclaim_low_watermark;
+    bool eased = sample.faults < LOAD_CONTROL_THRASHING_FAULTS / 2;
+    bool overdue = !list_empty (&suspended_list)
+                   && timer_elapsed (list_entry (list_front (&suspended_list), struct thread,
+                                                 suspend_elem)->suspended_at) >= LOAD_CONTROL_MAX_SUSPENSION;
+
+    /* A process suspended for too long takes its turn even while the system thrashes */
+    if (thrashing && !overdue && !sample.requested && sample.active > 1) {
+      /* The victim is flagged with interrupts still off, so it cannot have exited */
+      sample.victim->suspend_requested = true;
+    } else if ((eased || overdue || sample.active == 0) && !list_empty (&suspended_list)) {
+      struct thread *t = list_entry (list_pop_front (&suspended_list), struct thread, suspend_elem);
+      t->suspended = false;
+      load_control_resumptions++;
+      sema_up (&t->resume_sema);
+    }
+
+    intr_set_level (old_level);
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef VM_LOAD_CONTROL_H
+#define VM_LOAD_CONTROL_H
+
+#include "devices/timer.h"
+
+/* Ticks between samples of the fault rates */
+#define LOAD_CONTROL_PERIOD (TIMER_FREQ / 4)
+
+/* 
+  Major faults per period, across all processes, at which the system is
+  considered to be thrashing while the user pool is short of free pages 
+*/
+#define LOAD_CONTROL_THRASHING_FAULTS (32)
+
+/* Ticks after which a suspended process is resumed even if the system still thrashes */
+#define LOAD_CONTROL_MAX_SUSPENSION (TIMER_FREQ * 2)
+
+/* Load control statistics */
+extern long long load_control_suspensions;  /* Processes suspended */
+extern long long load_control_resumptions;  /* Processes resumed */
+
+/*
+  Starts the load control thread, which samples the major fault rates of 
+  the processes every LOAD_CONTROL_PERIOD. While the system is thrashing, 
+  the process with the highest fault rate is suspended, as long as another
+  process keeps running: its frames are evicted and it is kept off the 
+  ready list. Processes blocked waiting for a child are not counted as
+  running. Suspended processes are resumed one per period, longest 
+  suspended first, once the fault rate has dropped, once no process is 
+  running, or once one has been suspended for LOAD_CONTROL_MAX_SUSPENSION.
+  The thread is not started without swap space
+*/
+void load_control_init (void);
+
+/*
+  Suspends the current process if load control asked for it, returning
+  once it is resumed. Called where the process holds no locks: on system
+  call entry and at the end of page faults from user mode
+*/
+void load_control_safe_point (void);
+
+#endif /* vm/load-control.h */
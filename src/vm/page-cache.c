@@ -0,0 +1,111 @@
+#include "vm/page-cache.h"
+#include <debug.h>
+#include <list.h>
+#include "threads/synch.h"
+#include "userprog/syscall.h"
+#include "vm/share-table.h"
+
+size_t page_cache_pages;
+
+long long page_cache_hits;
+long long page_cache_reclaimed;
+long long page_cache_invalidated;
+
+/* Cached frames, in the order they were cached */
+static struct list cached_frames;
+
+void
+page_cache_init (void) {
+  list_init (&cached_frames);
+  page_cache_pages = 0;
+}
+
+bool
+page_cache_keep (frame_table_entry *f) {
+  ASSERT (f->can_be_shared && list_empty (&f->sharing_ptes));
+
+  if (f->in_transit) {
+    return false;
+  }
+
+  if (!f->holds_inode) {
+    if (!lock_held_by_current_thread (&file_system_lock)) {
+      return false;
+    }
+    inode_reopen (f->inode);
+    f->holds_inode = true;
+  }
+
+  f->cached = true;
+  list_push_back (&cached_frames, &f->cache_elem);
+  page_cache_pages++;
+  return true;
+}
+
+void
+page_cache_claim (frame_table_entry *f) {
+  ASSERT (f->cached);
+
+  list_remove (&f->cache_elem);
+  f->cached = false;
+  page_cache_pages--;
+  page_cache_hits++;
+}
+
+void
+page_cache_forget (frame_table_entry *f) {
+  if (f->cached) {
+    list_remove (&f->cache_elem);
+    f->cached = false;
+    page_cache_pages--;
+  }
+
+  if (f->holds_inode) {
+    ASSERT (lock_held_by_current_thread (&file_system_lock));
+    inode_close (f->inode);
+    f->holds_inode = false;
+  }
+}
+
+size_t
+page_cache_reclaim (frame_table_entry **victims, size_t count) {
+  size_t victim_count = 0;
+  struct list_elem *e;
+
+  for (e = list_begin (&cached_frames); e != list_end (&cached_frames) && victim_count < count;
+       e = list_next (e)) {
+    victims[victim_count++] = list_entry (e, frame_table_entry, cache_elem);
+  }
+
+  page_cache_reclaimed += victim_count;
+  return victim_count;
+}
+
+void
+page_cache_invalidate (struct inode *inode) {
+  /* Also covers the writes of the file system itself before any process runs */
+  if (page_cache_pages == 0) {
+    return;
+  }
+
+  /* Writes back from eviction already hold the table locks */
+  bool tables_acquired = !lock_held_by_current_thread (&frame_table_lock);
+  if (tables_acquired) {
+    lock_tables ();
+  }
+
+  struct list_elem *e = list_begin (&cached_frames);
+  while (e != list_end (&cached_frames)) {
+    frame_table_entry *f = list_entry (e, frame_table_entry, cache_elem);
+    e = list_next (e);
+
+    if (f->inode == inode) {
+      free_cached_frame (f);
+      page_cache_invalidated++;
+    }
+  }
+
+  if (tables_acquired) {
+    release_tables ();
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef VM_PAGE_CACHE_H
+#define VM_PAGE_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/inode.h"
+#include "vm/frame.h"
+
+/*
+  The page cache keeps the share table frames of read-only file pages
+  after the last page mapping them goes away. A cached frame stays in the
+  share table, so a later process running the same executable maps it
+  without reading the file again. Cached frames are reclaimed before any
+  mapped frame is evicted, oldest first.
+
+  A frame holds a reference to its inode from when it is first cached
+  until it leaves the share table, so the inode, and the key of the frame,
+  cannot be reused while the frame is in the table. Inodes are only opened
+  and closed with the file system lock held, so frames holding a reference
+  are only evicted by a thread holding that lock
+*/
+
+/* Page cache statistics */
+extern size_t page_cache_pages;              /* Frames currently cached */
+extern long long page_cache_hits;            /* Cached frames mapped again */
+extern long long page_cache_reclaimed;       /* Cached frames reclaimed by eviction */
+extern long long page_cache_invalidated;     /* Cached frames dropped as their file was written */
+
+void page_cache_init (void);
+
+/*
+  Keeps the share table frame, whose last sharer just left it, in the
+  page cache. Returns false if the frame cannot be kept, because its
+  contents were never read in or its inode cannot be opened without the
+  file system lock, in which case it must be freed. The table locks must
+  be held
+*/
+bool page_cache_keep (frame_table_entry *);
+
+/*
+  Takes the cached frame out of the page cache, as a page maps it again.
+  The table locks must be held
+*/
+void page_cache_claim (frame_table_entry *);
+
+/*
+  Records that the share table frame is being freed, taking it out of the
+  page cache and closing its inode if it holds a reference. The file
+  system lock must be held if it does, and the table locks must be held
+*/
+void page_cache_forget (frame_table_entry *);
+
+/*
+  Chooses up to COUNT cached frames to be evicted, oldest first, returning
+  how many were chosen. The table locks must be held, and the file system
+  lock must be held to evict them
+*/
+size_t page_cache_reclaim (frame_table_entry **, size_t);
+
+/*
+  Frees the cached frames of the inode, whose contents are about to be
+  written. The file system lock must be held if any frame is cached
+*/
+void page_cache_invalidate (struct inode *);
+
+#endif /* vm/page-cache.h */
@@ -0,0 +1,154 @@
+#include "vm/policy.h"
+#include <list.h>
+#include "vm/supp-page-table.h"
+
+/*
+  Scan resistant 2Q replacement. Pages faulted in for the first time enter
+  the A1in FIFO queue, which is evicted from while it holds more than its
+  share of the frames, so a sequential scan only displaces other pages of
+  A1in. Pages evicted from A1in are remembered in A1out, and pages faulted
+  in again while still remembered are hot, so they enter the Am queue,
+  which is managed with second chance. 
+
+  A1out holds no memory of its own: every page evicted from A1in is
+  stamped with the number of evictions from A1in so far, and it is still
+  in A1out while fewer than A1OUT_PAGES evictions followed it.
+*/
+
+/* Queues holding a frame */
+#define QUEUE_NONE (0)
+#define QUEUE_A1IN (1)
+#define QUEUE_AM (2)
+
+/* A1in is evicted from while it holds over a quarter of the used frames */
+#define A1IN_PAGES (frame_table_used / 4)
+
+/* A1out remembers as many pages as half the frame table */
+#define A1OUT_PAGES (frame_table_size / 2)
+
+static struct list a1in;
+static struct list am;
+static size_t a1in_size;
+
+/* Number of frames evicted from A1in, stamped on their pages. Never 0 */
+static unsigned a1in_evictions;
+
+static void
+two_queue_init (void) {
+  list_init (&a1in);
+  list_init (&am);
+  a1in_size = 0;
+  a1in_evictions = 1;
+}
+
+static void
+two_queue_frame_added (frame_table_entry *f) {
+  supp_pte *entry = (supp_pte *) f->creator;
+  bool in_a1out = entry->evicted_stamp != 0
+                  && a1in_evictions - entry->evicted_stamp < A1OUT_PAGES;
+  entry->evicted_stamp = 0;
+
+  if (in_a1out) {
+    f->queue = QUEUE_AM;
+    list_push_back (&am, &f->queue_elem);
+  } else {
+    f->queue = QUEUE_A1IN;
+    list_push_back (&a1in, &f->queue_elem);
+    a1in_size++;
+  }
+}
+
+static void
+two_queue_frame_freed (frame_table_entry *f) {
+  if (f->queue == QUEUE_NONE) {
+    return;
+  }
+  if (f->queue == QUEUE_A1IN) {
+    a1in_size--;
+  }
+  list_remove (&f->queue_elem);
+  f->queue = QUEUE_NONE;
+}
+
+/*
+  Adds F to the VICTIMS, unless it is already one, remembering the page
+  of a private frame evicted from A1in in A1out
+*/
+static void
+add_victim (frame_table_entry *f, frame_table_entry **victims, size_t *victim_count) {
+  for (size_t i = 0; i < *victim_count; i++) {
+    if (victims[i] == f) {
+      return;
+    }
+  }
+
+  if (f->queue == QUEUE_A1IN) {
+    if (!frame_is_shared (f)) {
+      ((supp_pte *) f->creator)->evicted_stamp = a1in_evictions;
+    }
+    if (++a1in_evictions == 0) {
+      a1in_evictions = 1;
+    }
+  }
+  victims[(*victim_count)++] = f;
+}
+
+/*
+  Chooses victims from the front of A1in while it is over its share, then
+  from Am, where referenced frames are given a second chance at the back.
+  If neither gives a victim, the first frame of either queue that can be
+  evicted is taken. Returns 0 if no frame can be evicted
+*/
+static size_t
+two_queue_choose_victims (frame_table_entry **victims, size_t count, bool files_writable) {
+  size_t victim_count = 0;
+  struct list_elem *e;
+
+  for (e = list_begin (&a1in); e != list_end (&a1in) && victim_count < count; e = list_next (e)) {
+    if (a1in_size - victim_count <= A1IN_PAGES) {
+      break;
+    }
+    frame_table_entry *f = list_entry (e, frame_table_entry, queue_elem);
+    if (frame_can_be_evicted (f, files_writable)) {
+      add_victim (f, victims, &victim_count);
+    }
+  }
+
+  size_t am_size = list_size (&am);
+  e = list_begin (&am);
+  for (size_t i = 0; i < am_size && victim_count < count; i++) {
+    frame_table_entry *f = list_entry (e, frame_table_entry, queue_elem);
+    struct list_elem *next = list_next (e);
+
+    if (!frame_can_be_evicted (f, files_writable)) {
+      /* Left in place */
+    } else if (frame_was_referenced (f) && !f->drop_behind) {
+      list_remove (e);
+      list_push_back (&am, e);
+    } else {
+      add_victim (f, victims, &victim_count);
+    }
+    e = next;
+  }
+
+  struct list *queues[] = { &a1in, &am };
+  for (int q = 0; q < 2 && victim_count == 0; q++) {
+    for (e = list_begin (queues[q]); e != list_end (queues[q]); e = list_next (e)) {
+      frame_table_entry *f = list_entry (e, frame_table_entry, queue_elem);
+      if (frame_can_be_evicted (f, files_writable)) {
+        add_victim (f, victims, &victim_count);
+        break;
+      }
+    }
+  }
+
+  return victim_count;
+}
+
+const eviction_policy two_queue_policy = {
+  .name = "2q",
+  .init = two_queue_init,
+  .frame_added = two_queue_frame_added,
+  .choose_victims = two_queue_choose_victims,
+  .frame_freed = two_queue_frame_freed,
+};
@@ -0,0 +1,155 @@
+#include "vm/policy.h"
+#include "devices/timer.h"
+#include "vm/stats.h"
+#include "vm/reclaim.h"
+
+/* Virtual time (in ticks of its owner's run time) a frame can go unreferenced
+   before it is considered to have left its owner's working set */
+#define WSCLOCK_TAU (TIMER_FREQ / 10)
+
+/* Maximum number of dirty frames whose write-back is scheduled in one sweep */
+#define WSCLOCK_MAX_WRITES (8)
+
+/* Index of the frame table entry the clock hand last examined */
+static size_t clock_hand;
+
+static void
+clock_init (void) {
+  clock_hand = 0;
+}
+
+/*
+  Moves the clock hand on to the next frame table entry, looping around
+  from the end to the start of the table, and returns that entry
+*/
+static frame_table_entry *
+advance_clock_hand (void) {
+  clock_hand = (clock_hand + 1) % frame_table_size;
+  if (clock_hand == 0) {
+    vm_stats.clock_revolutions++;
+  }
+  return &frame_table[clock_hand];
+}
+
+/*
+  Returns true if frame A is a better eviction candidate than frame B
+  when no frame outside of the working set could be found.
+  Clean frames are preferred, then older frames
+*/
+static bool
+better_fallback (bool dirty_a, int64_t age_a, bool dirty_b, int64_t age_b) {
+  if (dirty_a != dirty_b) {
+    return !dirty_a;
+  }
+  return age_a > age_b;
+}
+
+/* 
+  Chooses up to COUNT pages based on the WSClock page replacement algorithm.
+  
+  The hand sweeps the frame table once. Referenced frames have their last
+  use time refreshed and are skipped. An unreferenced frame whose age in its
+  owner's virtual time exceeds WSCLOCK_TAU, or that was left behind by
+  sequential access, has left the working set: it is
+  taken straight away if clean, otherwise memory mapped frames have their 
+  write-back scheduled and the hand moves on looking for a clean one.
+  Old dirty anonymous frames only make up the rest of the batch once the 
+  sweep is over, as they are written to swap as one clustered run.
+  The scheduled write-backs are handed to the reclaim thread, so the frames
+  are clean by the time the hand comes back to them. If the sweep finds 
+  nothing else, the first of them is instead written back synchronously,
+  holding the table locks, and evicted. If nothing has left any working set, the oldest
+  unreferenced frame (clean first) is evicted instead, and if every frame
+  was referenced, the first evictable one. Returns 0 if no frame can be
+  evicted at all.
+*/
+static size_t
+clock_choose_victims (frame_table_entry **victims, size_t count, bool files_writable) {
+  size_t victim_count = 0;
+
+  frame_table_entry *old_dirty[EVICTION_BATCH_SIZE];
+  size_t old_dirty_count = 0;
+
+  frame_table_entry *scheduled_writes[WSCLOCK_MAX_WRITES];
+  size_t scheduled_count = 0;
+
+  frame_table_entry *fallback = NULL;
+  bool fallback_dirty = false;
+  int64_t fallback_age = 0;
+
+  for (size_t i = 0; i < frame_table_size && victim_count < count; i++) {
+    frame_table_entry *hand = advance_clock_hand ();
+    if (!frame_can_be_evicted (hand, files_writable)) {
+      continue;
+    }
+    int64_t now = frame_owner (hand)->virtual_time;
+
+    /* Frames left behind by sequential access are taken even if referenced */
+    if (!hand->drop_behind && frame_was_referenced (hand)) {
+      /* Still in the working set */
+      hand->last_use = now;
+      continue;
+    }
+
+    int64_t age = hand->drop_behind ? INT64_MAX : now - hand->last_use;
+    bool dirty = frame_is_dirty (hand);
+
+    if (age > WSCLOCK_TAU) {
+      if (!dirty) {
+        victims[victim_count++] = hand;
+        continue;
+      }
+
+      if (frame_is_mmapped (hand)) {
+        if (scheduled_count < WSCLOCK_MAX_WRITES) {
+          scheduled_writes[scheduled_count++] = hand;
+        }
+      } else if (!frame_is_shared (hand) && old_dirty_count < count) {
+        old_dirty[old_dirty_count++] = hand;
+      }
+    }
+
+    if (fallback == NULL || better_fallback (dirty, age, fallback_dirty, fallback_age)) {
+      fallback = hand;
+      fallback_dirty = dirty;
+      fallback_age = age;
+    }
+  }
+
+  for (size_t i = 0; i < old_dirty_count && victim_count < count; i++) {
+    victims[victim_count++] = old_dirty[i];
+  }
+
+  size_t first_scheduled = 0;
+  if (victim_count == 0 && scheduled_count > 0) {
+    clean_frame (scheduled_writes[0]);
+    victims[victim_count++] = scheduled_writes[0];
+    first_scheduled = 1;
+  }
+  for (size_t i = first_scheduled; i < scheduled_count; i++) {
+    reclaim_schedule_write (scheduled_writes[i]);
+  }
+
+  if (victim_count == 0 && fallback != NULL) {
+    victims[victim_count++] = fallback;
+  }
+
+  /* 
+    Every evictable frame was referenced, and has now had its accessed bits
+    cleared. One more sweep takes the first of them, if there are any
+  */
+  for (size_t i = 0; i < frame_table_size && victim_count == 0; i++) {
+    frame_table_entry *hand = advance_clock_hand ();
+    if (frame_can_be_evicted (hand, files_writable)) {
+      victims[victim_count++] = hand;
+    }
+  }
+
+  return victim_count;
+}
+
+const eviction_policy clock_policy = {
+  .name = "clock",
+  .init = clock_init,
+  .choose_victims = clock_choose_victims,
+};
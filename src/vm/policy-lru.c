@@ -0,0 +1,80 @@
+#include "vm/policy.h"
+
+/*
+  LRU approximated with aging counters. Before every eviction the counter
+  of every frame is shifted right, with the frame's accessed bit shifted in
+  at the top, so frames referenced in recent scans have the highest counts.
+  The frames with the lowest counts are evicted, clean ones first on ties.
+*/
+
+/* Counter of a frame that has just been referenced */
+#define AGE_REFERENCED (0x80)
+
+static void
+lru_frame_added (frame_table_entry *f) {
+  f->age = AGE_REFERENCED;
+}
+
+static void
+lru_scan_accessed (void) {
+  for (size_t i = 0; i < frame_table_size; i++) {
+    frame_table_entry *f = &frame_table[i];
+    if (f->kpage == NULL || f->in_transit) {
+      continue;
+    }
+
+    f->age >>= 1;
+    if (f->drop_behind) {
+      f->age = 0;
+    } else if (frame_was_referenced (f)) {
+      f->age |= AGE_REFERENCED;
+    }
+  }
+}
+
+/*
+  Returns true if frame A should be evicted before frame B
+*/
+static bool
+evict_before (frame_table_entry *a, frame_table_entry *b) {
+  if (a->age != b->age) {
+    return a->age < b->age;
+  }
+  return !frame_is_dirty (a) && frame_is_dirty (b);
+}
+
+/*
+  Keeps the COUNT frames with the lowest counters in VICTIMS, sorted with
+  the lowest first. Returns 0 if no frame can be evicted
+*/
+static size_t
+lru_choose_victims (frame_table_entry **victims, size_t count, bool files_writable) {
+  size_t victim_count = 0;
+
+  for (size_t i = 0; i < frame_table_size; i++) {
+    frame_table_entry *f = &frame_table[i];
+    if (!frame_can_be_evicted (f, files_writable)) {
+      continue;
+    }
+    if (victim_count == count && !evict_before (f, victims[count - 1])) {
+      continue;
+    }
+
+    /* Insert into the sorted victims, dropping the last if they are full */
+    size_t pos = victim_count < count ? victim_count++ : count - 1;
+    while (pos > 0 && evict_before (f, victims[pos - 1])) {
+      victims[pos] = victims[pos - 1];
+      pos--;
+    }
+    victims[pos] = f;
+  }
+
+  return victim_count;
+}
+
+const eviction_policy lru_policy = {
+  .name = "lru",
+  .frame_added = lru_frame_added,
+  .scan_accessed = lru_scan_accessed,
+  .choose_victims = lru_choose_victims,
+};
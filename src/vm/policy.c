@@ -0,0 +1,22 @@
+#include "vm/policy.h"
+#include <string.h>
+
+const eviction_policy *active_policy = &clock_policy;
+
+/* Policies that can be selected with -vm-policy= */
+static const eviction_policy *policies[] = {
+  &clock_policy,
+  &lru_policy,
+  &two_queue_policy,
+};
+
+bool
+select_eviction_policy (const char *name) {
+  for (size_t i = 0; i < sizeof policies / sizeof *policies; i++) {
+    if (!strcmp (policies[i]->name, name)) {
+      active_policy = policies[i];
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,48 @@
+#ifndef VM_POLICY_H
+#define VM_POLICY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "vm/frame.h"
+
+/*
+  Page replacement policy used by evict. Every hook is called with the
+  table locks held. Hooks a policy has no use for may be NULL
+*/
+typedef struct {
+  const char *name;
+
+  /* Sets up the policy once the frame table is initialised */
+  void (*init) (void);
+
+  /* Called when a frame is given a page */
+  void (*frame_added) (frame_table_entry *);
+
+  /* Called before victims are chosen, to sample the accessed bits of frames */
+  void (*scan_accessed) (void);
+
+  /* 
+    Stores up to COUNT frames to evict in VICTIMS, returning how many, or 0
+    if no frame can be evicted. Only frames frame_can_be_evicted accepts may
+    be chosen, given whether dirty memory mapped frames can be written back
+  */
+  size_t (*choose_victims) (frame_table_entry **victims, size_t count, bool files_writable);
+
+  /* Called when the page of a frame is freed, whether evicted or not */
+  void (*frame_freed) (frame_table_entry *);
+} eviction_policy;
+
+/* The policies that can be selected */
+extern const eviction_policy clock_policy;
+extern const eviction_policy lru_policy;
+extern const eviction_policy two_queue_policy;
+
+/* Policy in use, WSClock unless another is selected with -vm-policy= */
+extern const eviction_policy *active_policy;
+
+/*
+  Selects the policy with the given name. Returns false if there is none
+*/
+bool select_eviction_policy (const char *name);
+
+#endif
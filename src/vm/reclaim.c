@@ -0,0 +1,147 @@
+#include "vm/reclaim.h"
+#include <debug.h>
+#include "devices/block.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/syscall.h"
+#include "vm/frame.h"
+
+size_t reclaim_low_watermark = RECLAIM_LOW_WATERMARK;
+size_t reclaim_high_watermark = RECLAIM_HIGH_WATERMARK;
+
+long long reclaim_runs;
+long long reclaim_pages;
+
+/* Semaphore the reclaim thread waits on between passes */
+static struct semaphore reclaim_sema;
+
+/* 
+  Records that the reclaim thread has been woken and has not finished its
+  pass yet. Protected by the frame table lock
+*/
+static bool reclaim_pending;
+
+/* Records whether the reclaim thread is running */
+static bool reclaim_enabled;
+
+/* 
+  Frames whose write-back was handed to the reclaim thread. Protected by 
+  the frame table lock
+*/
+static frame_table_entry *pending_writes[RECLAIM_MAX_WRITES];
+static size_t pending_write_cnt;
+
+static thread_func reclaim_thread NO_RETURN;
+static void clean_pending_writes (void);
+
+void
+reclaim_init (void) {
+  sema_init (&reclaim_sema, 0);
+  reclaim_pending = false;
+  reclaim_enabled = false;
+  pending_write_cnt = 0;
+
+  /* Dirty anonymous pages can only be reclaimed into swap space */
+  if (block_get_role (BLOCK_SWAP) == NULL) {
+    return;
+  }
+
+  /* Keep the watermarks within the user pool */
+  size_t user_pages = palloc_user_pages ();
+  if (reclaim_high_watermark > user_pages / 2) {
+    reclaim_high_watermark = user_pages / 2;
+  }
+  if (reclaim_low_watermark >= reclaim_high_watermark) {
+    reclaim_low_watermark = reclaim_high_watermark / 2;
+  }
+  if (reclaim_low_watermark == 0) {
+    return;
+  }
+
+  reclaim_enabled = thread_create ("reclaim", PRI_DEFAULT, reclaim_thread, NULL) != TID_ERROR;
+}
+
+void
+reclaim_wake (void) {
+  if (reclaim_enabled && !reclaim_pending 
+      && palloc_user_free_pages () < reclaim_low_watermark) {
+    reclaim_pending = true;
+    sema_up (&reclaim_sema);
+  }
+}
+
+void
+reclaim_schedule_write (frame_table_entry *f) {
+  ASSERT (lock_held_by_current_thread (&frame_table_lock));
+  if (!reclaim_enabled || pending_write_cnt == RECLAIM_MAX_WRITES) {
+    return;
+  }
+
+  for (size_t i = 0; i < pending_write_cnt; i++) {
+    if (pending_writes[i] == f) {
+      return;
+    }
+  }
+  pending_writes[pending_write_cnt++] = f;
+
+  if (!reclaim_pending) {
+    reclaim_pending = true;
+    sema_up (&reclaim_sema);
+  }
+}
+
+/*
+  Writes back the frames handed to the reclaim thread that are still dirty
+  memory mapped frames. A frame may have been evicted, or even given to 
+  another page, since. The file system lock and the table locks must be held
+*/
+static void
+clean_pending_writes (void) {
+  for (size_t i = 0; i < pending_write_cnt; i++) {
+    frame_table_entry *f = pending_writes[i];
+    if (frame_can_be_evicted (f, true) && frame_is_mmapped (f) && frame_is_dirty (f)) {
+      clean_frame (f);
+    }
+  }
+  pending_write_cnt = 0;
+}
+
+/*
+  Issues the write-backs handed to the thread, then evicts frames one batch
+  at a time until the high watermark is reached.
+  The locks are released between batches, so faulting threads are not
+  held up for the whole pass
+*/
+static void
+reclaim_thread (void *aux UNUSED) {
+  for (;;) {
+    sema_down (&reclaim_sema);
+    reclaim_runs++;
+
+    bool done = false;
+    while (!done) {
+      lock_acquire (&file_system_lock);
+      lock_tables ();
+      clean_pending_writes ();
+
+      size_t free_pages = palloc_user_free_pages ();
+      if (free_pages >= reclaim_high_watermark || frame_table_used == 0) {
+        reclaim_pending = false;
+        done = true;
+      } else {
+        size_t evicted = evict (reclaim_high_watermark - free_pages);
+        reclaim_pages += evicted;
+
+        /* Nothing can be evicted until frames leave transit or are unpinned */
+        if (evicted == 0) {
+          reclaim_pending = false;
+          done = true;
+        }
+      }
+
+      release_tables ();
+      lock_release (&file_system_lock);
+    }
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef VM_RECLAIM_H
+#define VM_RECLAIM_H
+
+#include <stddef.h>
+#include "vm/frame.h"
+
+/* Default number of free user pages below which the reclaim thread is woken */
+#define RECLAIM_LOW_WATERMARK (16)
+
+/* Default number of free user pages the reclaim thread evicts frames up to */
+#define RECLAIM_HIGH_WATERMARK (32)
+
+/* Maximum number of write-backs waiting for the reclaim thread */
+#define RECLAIM_MAX_WRITES (16)
+
+/*
+  Free user page watermarks, set with -vm-low= and -vm-high= on the
+  kernel command line
+*/
+extern size_t reclaim_low_watermark;
+extern size_t reclaim_high_watermark;
+
+/* Reclaim statistics */
+extern long long reclaim_runs;             /* Times the reclaim thread was woken */
+extern long long reclaim_pages;            /* Frames evicted by the reclaim thread */
+
+/*
+  Starts the reclaim thread, which evicts frames in the background whenever
+  the number of free user pages drops below the low watermark, until it is
+  back at the high watermark. The thread is not started without swap space
+*/
+void reclaim_init (void);
+
+/*
+  Wakes the reclaim thread if the user pool is below the low watermark.
+  The frame table lock must be held
+*/
+void reclaim_wake (void);
+
+/*
+  Hands the write-back of a dirty memory mapped frame to the reclaim thread,
+  waking it, so the frame is clean when the eviction policy next comes to 
+  it. The write is dropped if the reclaim thread is not running or too
+  many are waiting. The frame table lock must be held
+*/
+void reclaim_schedule_write (frame_table_entry *);
+
+#endif /* vm/reclaim.h */
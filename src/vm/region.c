@@ -0,0 +1,131 @@
+#include "vm/region.h"
+#include <debug.h>
+#include "threads/malloc.h"
+#include "threads/vaddr.h"
+#include "userprog/syscall.h"
+
+region *
+create_region (struct file *file, off_t ofs, uint8_t *upage,
+               uint32_t read_bytes, uint32_t zero_bytes, bool writable, enum source source)
+{
+  ASSERT ((read_bytes + zero_bytes) % PGSIZE == 0);
+  ASSERT (pg_ofs (upage) == 0);
+
+  region *r = (region *) malloc (sizeof (region));
+  if (!r) {
+    return NULL;
+  }
+  r->start = upage;
+  r->end = upage + read_bytes + zero_bytes;
+  r->file = file;
+  r->ofs = ofs;
+  r->read_bytes = read_bytes;
+  r->writable = writable;
+  r->page_source = source;
+  r->map = NULL;
+  r->advice = ADVICE_NORMAL;
+
+  list_push_back (&thread_current ()->regions, &r->elem);
+  return r;
+}
+
+void
+destroy_region (region *r) {
+  list_remove (&r->elem);
+  free (r);
+}
+
+void
+destroy_regions (struct thread *t) {
+  while (!list_empty (&t->regions)) {
+    destroy_region (list_entry (list_front (&t->regions), region, elem));
+  }
+}
+
+region *
+find_region (struct thread *t, const void *uaddr) {
+  struct list_elem *e;
+  for (e = list_begin (&t->regions); e != list_end (&t->regions); e = list_next (e)) {
+    region *r = list_entry (e, region, elem);
+    if ((const uint8_t *) uaddr >= r->start && (const uint8_t *) uaddr < r->end) {
+      return r;
+    }
+  }
+  return NULL;
+}
+
+bool
+range_is_unmapped (struct thread *t, const void *start_ptr, const void *end_ptr) {
+  const uint8_t *start = pg_round_down (start_ptr);
+  const uint8_t *end = end_ptr;
+
+  struct list_elem *e;
+  for (e = list_begin (&t->regions); e != list_end (&t->regions); e = list_next (e)) {
+    region *r = list_entry (e, region, elem);
+    if (start < r->end && r->start < end) {
+      return false;
+    }
+  }
+
+  /* 
+    Only pages outside every region, such as stack pages, remain. 
+    Look up the pages of the range or walk the table, whichever is smaller
+  */
+  size_t page_count = (end - start + PGSIZE - 1) / PGSIZE;
+  if (page_count <= hash_size (&t->supp_page_table)) {
+    for (const uint8_t *upage = start; upage < end; upage += PGSIZE) {
+      if (find_supp_pte (t, upage) != NULL) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  struct hash_iterator i;
+  hash_first (&i, &t->supp_page_table);
+  while (hash_next (&i)) {
+    supp_pte *entry = hash_entry (hash_cur (&i), supp_pte, elem);
+    if (entry->uaddr >= start && entry->uaddr < end) {
+      return false;
+    }
+  }
+  return true;
+}
+
+supp_pte *
+get_supp_pte (struct thread *t, const void *uaddr) {
+  supp_pte *entry = find_supp_pte (t, uaddr);
+  if (entry != NULL) {
+    return entry;
+  }
+
+  region *r = find_region (t, uaddr);
+  if (r == NULL) {
+    return NULL;
+  }
+
+  /* 
+    Calculate how to fill this page of the region.
+    Reads PAGE_READ_BYTES bytes from the file and zeroes the rest
+  */
+  uint8_t *upage = pg_round_down (uaddr);
+  uint32_t region_ofs = upage - r->start;
+  uint32_t page_read_bytes = 0;
+  if (r->read_bytes > region_ofs) {
+    page_read_bytes = r->read_bytes - region_ofs < PGSIZE ? r->read_bytes - region_ofs : PGSIZE;
+  }
+
+  entry = create_supp_pte (r->file, r->ofs + region_ofs, upage, page_read_bytes,
+                           PGSIZE - page_read_bytes, r->writable, r->page_source);
+  if (entry == NULL) {
+    return NULL;
+  }
+  entry->thread = t;
+  hash_insert (&t->supp_page_table, &entry->elem);
+
+  if (r->map != NULL) {
+    entry->map = r->map;
+    list_push_back (&r->map->pages, &entry->map_elem);
+  }
+  return entry;
+}
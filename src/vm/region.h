@@ -0,0 +1,77 @@
+#ifndef VM_REGION_H
+#define VM_REGION_H
+
+#include "lib/kernel/list.h"
+#include "filesys/off_t.h"
+#include "filesys/file.h"
+#include "threads/thread.h"
+#include "vm/supp-page-table.h"
+
+/* Access pattern of a region, as advised with madvise */
+enum region_advice {
+  ADVICE_NORMAL,                 /* No advice - pages around faults are loaded */
+  ADVICE_RANDOM,                 /* Only faulting pages are loaded */
+  ADVICE_SEQUENTIAL              /* Pages after faults are loaded, pages behind are evicted first */
+};
+
+/*
+  Struct for a region of a thread's address space - a run of pages with the
+  same source, backed by consecutive pages of the same file.
+  Supplemental page table entries are only created for the pages of a region
+  that are accessed
+*/
+typedef struct region {
+  uint8_t *start;                     /* Base address of the first page */
+  uint8_t *end;                       /* Address just past the last page */
+  struct file *file;                  /* File storing the data of the region */
+  off_t ofs;                          /* Offset in the file of the first page */
+  uint32_t read_bytes;                /* No. of bytes read from the file, the rest of the region is zeroed */
+  bool writable;                      /* Records if the pages should be writable or read-only */
+  enum source page_source;            /* Records the source of the pages */
+  struct mapped_file *map;            /* Memory mapping of the region. Only used for MMAP and ANON regions */
+  enum region_advice advice;          /* Access pattern advised for the region */
+
+  struct list_elem elem;              /* List elem for the regions of a thread */
+} region;
+
+/*
+  Creates a region in the current thread's address space covering the
+  READ_BYTES + ZERO_BYTES bytes from UPAGE, whose first READ_BYTES bytes
+  are read from FILE starting at OFS.
+  Returns NULL if memory allocation fails
+*/
+region *create_region (struct file *, off_t, uint8_t *,
+                       uint32_t, uint32_t, bool, enum source);
+
+/*
+  Removes the region from its thread's address space and frees it.
+  Supplemental page table entries of its pages must be freed separately
+*/
+void destroy_region (region *);
+
+/*
+  Frees all the regions of the given thread
+*/
+void destroy_regions (struct thread *);
+
+/*
+  Returns the region of the thread containing the address, 
+  or NULL if there is none
+*/
+region *find_region (struct thread *, const void *);
+
+/*
+  Returns true if no page from START up to END is mapped in the thread's
+  address space, by a region or by a supplemental page table entry
+*/
+bool range_is_unmapped (struct thread *, const void *, const void *);
+
+/*
+  Returns the supplemental page table entry of the thread for the page
+  containing the address, creating it from the region containing the page
+  if it has not been accessed before. 
+  Returns NULL if the address is not mapped or memory allocation fails
+*/
+supp_pte *get_supp_pte (struct thread *, const void *);
+
+#endif /* vm/region.h */
@@ -17,12 +17,24 @@ create_share_entry (supp_pte *pte, frame_table_entry *frame) {
     }
 
     entry->frame = frame;
-    list_init (&entry->sharing_ptes);
-    list_push_back (&entry->sharing_ptes, &pte->share_elem);
+    list_push_back (&frame->sharing_ptes, &pte->share_elem);
     return entry;
 }
 
 
+share_entry *
+find_share_entry (frame_table_entry *frame) {
+    share_entry search;
+    search.frame = frame;
+
+    struct hash_elem *found = hash_find (&share_table, &search.elem);
+    if (found == NULL) {
+      return NULL;
+    }
+    return hash_entry (found, share_entry, elem);
+}
+
+
 
 void 
 init_share_table (void) {
@@ -35,7 +47,8 @@ init_share_table (void) {
 unsigned 
 share_hash (const struct hash_elem *e, void *aux UNUSED) {
   const share_entry *entry = hash_entry (e, share_entry, elem);
-  return hash_int ((int) entry->frame->inode) + hash_int (entry->frame->ofs);
+  return hash_int ((int) entry->frame->inode) + hash_int (entry->frame->ofs)
+         + hash_int (entry->frame->read_bytes);
 }
 
 
@@ -53,7 +66,14 @@ share_hash_compare (const struct hash_elem *a, const struct hash_elem *b, void *
   if (entryA_inode < entryB_inode) {
     return true;
   } else if (entryA_inode == entryB_inode){
-    return entryA_ofs < entryB_ofs;
+    /* 
+      Segments may share a page of the file but read different amounts of
+      it, zeroing the rest, so only pages reading the same bytes match
+    */
+    if (entryA_ofs != entryB_ofs) {
+      return entryA_ofs < entryB_ofs;
+    }
+    return entryA->frame->read_bytes < entryB->frame->read_bytes;
   } else {
     return false;
   }
@@ -23,8 +23,7 @@ extern struct lock share_table_lock;
   Struct for an entry in the share table
 */
 typedef struct {
-  frame_table_entry *frame;        /* Frame of memory being shared */
-  struct list sharing_ptes;        /* List of supplemental page table entries that share the frame */
+  frame_table_entry *frame;        /* Frame of memory being shared, holding the list of sharing entries */
   struct hash_elem elem;           /* Hash table elem */
 } share_entry;
 
@@ -38,6 +37,13 @@ typedef struct {
 share_entry *create_share_entry (supp_pte *, frame_table_entry *);
 
 
+/*
+  Returns the share table entry for the given frame, NULL if the frame
+  is not being shared
+*/
+share_entry *find_share_entry (frame_table_entry *);
+
+
 /*
   Initialises the global Share Table
 */
@@ -52,7 +58,7 @@ unsigned share_hash (const struct hash_elem *, void *);
 
 /* 
   Comparison function for the Share Table using the keys 
-  (inode and offset of file) for table entries
+  (inode, offset and bytes read of file) for table entries
 */
 bool share_hash_compare (const struct hash_elem *, const struct hash_elem *, void *);
 
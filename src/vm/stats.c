@@ -0,0 +1,73 @@
+#include "vm/stats.h"
+#include <debug.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+
+struct vm_stats vm_stats;
+
+/* Names of the fault sources, indexed by VM_FAULT_* */
+static const char *fault_source_names[VM_FAULT_SOURCES] = {
+  "mmap", "stack", "disk", "swap", "shared", "stack growth", "zero page", "copy-on-write", "anonymous"
+};
+
+/*
+  Returns the latency histogram bucket of a fault taking CYCLES
+*/
+static int
+latency_bucket (uint64_t cycles) {
+  int bucket = 0;
+  cycles >>= VM_LATENCY_SHIFT;
+  while (cycles > 0 && bucket < VM_LATENCY_BUCKETS - 1) {
+    cycles >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void
+vm_stats_record_fault (int source, uint64_t start) {
+  ASSERT (source >= 0 && source < VM_FAULT_SOURCES);
+  uint64_t cycles = vm_stats_clock () - start;
+  struct vm_fault_stats *s = &vm_stats.faults[source];
+
+  /* Faults of different threads may be recorded at once */
+  enum intr_level old_level = intr_disable ();
+  s->count++;
+  s->total_cycles += cycles;
+  if (cycles > s->max_cycles) {
+    s->max_cycles = cycles;
+  }
+  s->latency[latency_bucket (cycles)]++;
+  intr_set_level (old_level);
+}
+
+void
+vm_stats_snapshot (struct vm_stats *stats) {
+  enum intr_level old_level = intr_disable ();
+  *stats = vm_stats;
+  intr_set_level (old_level);
+}
+
+void
+vm_stats_print (void) {
+  struct vm_stats stats;
+  vm_stats_snapshot (&stats);
+
+  printf ("VM faults (cycles, histogram buckets from 2^%d):\n", VM_LATENCY_SHIFT);
+  for (int i = 0; i < VM_FAULT_SOURCES; i++) {
+    struct vm_fault_stats *s = &stats.faults[i];
+    if (s->count == 0) {
+      continue;
+    }
+    printf ("  %-13s %llu faults, avg %llu, max %llu:", fault_source_names[i],
+            s->count, s->total_cycles / s->count, s->max_cycles);
+    for (int b = 0; b < VM_LATENCY_BUCKETS; b++) {
+      printf (" %u", (unsigned) s->latency[b]);
+    }
+    printf ("\n");
+  }
+  printf ("VM: %llu evictions, %llu file write-backs, %llu swap writes, "
+          "%llu swap slots in use, %llu clock revolutions\n",
+          stats.evictions, stats.file_writebacks, stats.swap_writes,
+          stats.swap_slots_used, stats.clock_revolutions);
+}
@@ -0,0 +1,40 @@
+#ifndef VM_STATS_H
+#define VM_STATS_H
+
+#include <stdint.h>
+#include "lib/user/syscall.h"
+
+/*
+  Counters of the virtual memory system. Fault statistics are updated by
+  the page fault handler, eviction and write-back counters under the frame
+  table lock and the swap slot count under the swap slot lock
+*/
+extern struct vm_stats vm_stats;
+
+/*
+  Returns the time stamp counter, used to measure fault latency
+*/
+static inline uint64_t
+vm_stats_clock (void) {
+  uint64_t tsc;
+  asm volatile ("rdtsc" : "=A" (tsc));
+  return tsc;
+}
+
+/*
+  Records a fault of the given VM_FAULT_* SOURCE that started at
+  time stamp START
+*/
+void vm_stats_record_fault (int source, uint64_t start);
+
+/*
+  Copies the current statistics into STATS
+*/
+void vm_stats_snapshot (struct vm_stats *stats);
+
+/*
+  Prints the statistics
+*/
+void vm_stats_print (void);
+
+#endif
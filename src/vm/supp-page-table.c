@@ -2,6 +2,8 @@
 #include "threads/malloc.h"
 #include <debug.h>
 #include "vm/swap.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
 
 unsigned 
 supp_hash (const struct hash_elem *e, void *aux UNUSED) {
@@ -22,15 +24,11 @@ supp_destroy (struct hash_elem *e, void *aux UNUSED) {
 
   supp_pte *supp_entry = hash_entry (e, supp_pte, elem);
 
+  release_page_lock (supp_entry);
   free_frame_from_supp_pte (e, thread_current ());
 
-  swap_entry search_entry;
-  search_entry.supp_pte = supp_entry;
-  struct hash_elem *to_delete_swap_elem = hash_find (&swap_table, &search_entry.elem);
-  if (to_delete_swap_elem != NULL) {
-    swap_entry *to_delete_swap_entry = hash_entry (to_delete_swap_elem, swap_entry, elem);
-    hash_delete (&swap_table, to_delete_swap_elem);
-    free (to_delete_swap_entry);
+  if (supp_entry->is_in_swap_space) {
+    release_swap_slot (supp_entry);
   }
 
   free (supp_entry);
@@ -52,8 +50,20 @@ create_supp_pte (struct file *file, off_t ofs, uint8_t *upage,
   entry->writable = writable;
   entry->page_source = source;
   entry->page_frame = NULL;
+  entry->pin_count = 0;
+  entry->mlocked = false;
+  entry->evicted_stamp = 0;
   entry->is_in_swap_space = false;
+  entry->swap_slot = BITMAP_ERROR;
+  entry->map = NULL;
 
   entry->thread = thread_current ();
   return entry;
-}
\ No newline at end of file
+}
+supp_pte *
+find_supp_pte (struct thread *t, const void *uaddr) {
+  supp_pte query;
+  query.uaddr = pg_round_down (uaddr);
+  struct hash_elem *found_elem = hash_find (&t->supp_page_table, &query.elem);
+  return found_elem != NULL ? hash_entry (found_elem, supp_pte, elem) : NULL;
+}
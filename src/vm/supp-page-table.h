@@ -10,9 +10,12 @@
 enum source {
   MMAP,                          /* Loading from a memory-mapped file */   
   STACK,                         /* Stack Page */  
-  DISK                           /* Stored on file system */
+  DISK,                          /* Stored on file system */
+  ANON                           /* Anonymous mapping, zero-filled and swapped like the stack */
 };
 
+struct mapped_file;
+
 /*
   Struct for an entry in a supplemental page table, a hash table
 */
@@ -25,13 +28,24 @@ typedef struct {
   bool writable;                      /* Records if page should be writable or read-only */
   enum source page_source;            /* Records the source of the page */
   bool is_in_swap_space;              /* Records if a page is in swap */
+  size_t swap_slot;                   /* Page slot in BLOCK_SWAP holding the page, or
+                                         BITMAP_ERROR if held in the swap cache */
+  size_t swap_cache_chunk;            /* First swap cache chunk holding the page */
+  uint16_t swap_cache_size;           /* Compressed size of the page in the swap cache */
   
   frame_table_entry *page_frame;      /* Pointer to page frame if page is loaded to frame table, null otherwise */
+  unsigned pin_count;                 /* Number of pins keeping the page's frame from eviction */
+  bool mlocked;                       /* Records if the page is locked by mlock, holding one pin */
+  unsigned evicted_stamp;             /* 2Q count of evictions from A1in when the page was
+                                         evicted from it, 0 if it was not */
 
   struct thread *thread;              /* Thread that owns the supplemental page table */
 
+  struct mapped_file *map;            /* Memory mapping the page belongs to. Only used for MMAP and ANON pages */
+
   struct hash_elem elem;              /* Hash table elem */
   struct list_elem share_elem;        /* List elem for share table */ 
+  struct list_elem map_elem;          /* List elem for the pages of a memory mapping */
 } supp_pte;
 
 
@@ -60,4 +74,10 @@ void supp_destroy (struct hash_elem *e, void *);
 supp_pte *create_supp_pte (struct file *, off_t, uint8_t *,
                            uint32_t, uint32_t, bool, enum source);
 
+/*
+  Returns the supplemental page table entry of the thread for the page
+  containing the address, or NULL if the page has no entry
+*/
+supp_pte *find_supp_pte (struct thread *, const void *);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,264 @@
+#include "vm/swap-cache.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <round.h>
+#include <string.h>
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/*
+  Compressed pages are stored in the chunks of up to SWAP_CACHE_PAGES
+  kernel pages. A compressed page occupies a run of chunks inside a
+  single cache page, so it can be read back with one copy.
+
+  Pages are compressed with a small LZ77 codec. The compressed stream
+  is a sequence of tokens:
+
+    0x00 - 0x7f   a run of (token + 1) literal bytes follows
+    0x80 - 0xff   copy (token - 0x80 + LZ_MIN_MATCH) bytes from the
+                  two byte little endian distance that follows
+
+  Matches are found through a hash table of the last position each
+  four byte sequence was seen at.
+*/
+
+#define CHUNKS_PER_PAGE (PGSIZE / SWAP_CACHE_CHUNK_SIZE)
+
+#define LZ_MIN_MATCH (4)
+#define LZ_MAX_MATCH (0x7f + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS (0x80)
+#define LZ_HASH_BITS (12)
+
+long long swap_cache_stores;
+long long swap_cache_loads;
+long long swap_cache_rejects;
+long long swap_cache_full;
+
+/* Pages of the cache, allocated when first needed */
+static uint8_t *cache_pages[SWAP_CACHE_PAGES];
+
+/* Occupancy of the chunks of every cache page */
+static struct bitmap *chunk_map;
+
+/* 
+  Match table and output buffer of the compressor. They are too large for
+  a kernel stack and are protected by the swap cache lock
+*/
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+static uint8_t lz_buffer[SWAP_CACHE_MAX_COMPRESSED];
+
+/* Lock to ensure synchronized access to the cache and the compressor */
+static struct lock swap_cache_lock;
+
+static size_t lz_compress (const uint8_t *, uint8_t *, size_t);
+static void lz_decompress (const uint8_t *, size_t, uint8_t *);
+static uint8_t *chunk_address (size_t);
+static size_t allocate_chunks (size_t);
+
+void
+swap_cache_init (void) {
+  chunk_map = bitmap_create (SWAP_CACHE_PAGES * CHUNKS_PER_PAGE);
+  ASSERT (chunk_map != NULL);
+  lock_init (&swap_cache_lock);
+}
+
+bool
+swap_cache_store (const void *page, size_t *chunk, uint16_t *size) {
+  lock_acquire (&swap_cache_lock);
+
+  size_t compressed_size = lz_compress (page, lz_buffer, sizeof lz_buffer);
+  if (compressed_size == 0) {
+    swap_cache_rejects++;
+    lock_release (&swap_cache_lock);
+    return false;
+  }
+
+  size_t index = allocate_chunks (DIV_ROUND_UP (compressed_size, SWAP_CACHE_CHUNK_SIZE));
+  if (index == BITMAP_ERROR) {
+    swap_cache_full++;
+    lock_release (&swap_cache_lock);
+    return false;
+  }
+
+  memcpy (chunk_address (index), lz_buffer, compressed_size);
+  *chunk = index;
+  *size = compressed_size;
+  swap_cache_stores++;
+
+  lock_release (&swap_cache_lock);
+  return true;
+}
+
+void
+swap_cache_read (size_t chunk, uint16_t size, void *page) {
+  lock_acquire (&swap_cache_lock);
+  lz_decompress (chunk_address (chunk), size, page);
+  swap_cache_loads++;
+  lock_release (&swap_cache_lock);
+}
+
+void
+swap_cache_free (size_t chunk, uint16_t size) {
+  size_t chunk_count = DIV_ROUND_UP (size, SWAP_CACHE_CHUNK_SIZE);
+
+  lock_acquire (&swap_cache_lock);
+  ASSERT (bitmap_all (chunk_map, chunk, chunk_count));
+  bitmap_set_multiple (chunk_map, chunk, chunk_count, false);
+  lock_release (&swap_cache_lock);
+}
+
+/*
+  Returns the address of the given chunk
+*/
+static uint8_t *
+chunk_address (size_t chunk) {
+  return cache_pages[chunk / CHUNKS_PER_PAGE] + (chunk % CHUNKS_PER_PAGE) * SWAP_CACHE_CHUNK_SIZE;
+}
+
+/*
+  Finds and marks as used a run of CHUNK_COUNT free chunks inside one 
+  cache page, allocating a new cache page if no existing one has room.
+  Returns the first chunk of the run, or BITMAP_ERROR if there is no room
+*/
+static size_t
+allocate_chunks (size_t chunk_count) {
+  for (size_t p = 0; p < SWAP_CACHE_PAGES; p++) {
+    if (cache_pages[p] == NULL) {
+      cache_pages[p] = palloc_get_page (0);
+      if (cache_pages[p] == NULL) {
+        return BITMAP_ERROR;
+      }
+    }
+
+    size_t page_start = p * CHUNKS_PER_PAGE;
+    size_t index = bitmap_scan (chunk_map, page_start, chunk_count, false);
+    if (index == BITMAP_ERROR) {
+      return BITMAP_ERROR;
+    }
+    size_t index_page = index / CHUNKS_PER_PAGE;
+    if (index_page != p) {
+      /* Nothing fits in this page - continue from the page the run starts in */
+      p = index_page - 1;
+      continue;
+    }
+    if (index + chunk_count <= page_start + CHUNKS_PER_PAGE) {
+      bitmap_set_multiple (chunk_map, index, chunk_count, true);
+      return index;
+    }
+  }
+  return BITMAP_ERROR;
+}
+
+/*
+  Returns the hash of the four bytes at P
+*/
+static inline unsigned
+lz_hash (const uint8_t *p) {
+  uint32_t v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/*
+  Appends the literal run from START to END to the output at OUT,
+  returning the new end of the output, or NULL if it would pass OUT_END
+*/
+static uint8_t *
+lz_emit_literals (const uint8_t *start, const uint8_t *end, uint8_t *out, uint8_t *out_end) {
+  while (start < end) {
+    size_t run = end - start < LZ_MAX_LITERALS ? (size_t) (end - start) : LZ_MAX_LITERALS;
+    if (out + 1 + run > out_end) {
+      return NULL;
+    }
+    *out++ = run - 1;
+    memcpy (out, start, run);
+    out += run;
+    start += run;
+  }
+  return out;
+}
+
+/*
+  Compresses the page at IN into OUT, which has room for OUT_SIZE bytes.
+  Returns the compressed size, or 0 if the page does not fit in OUT_SIZE
+*/
+static size_t
+lz_compress (const uint8_t *in, uint8_t *out, size_t out_size) {
+  const uint8_t *in_end = in + PGSIZE;
+  const uint8_t *match_limit = in_end - LZ_MIN_MATCH;
+  uint8_t *out_start = out;
+  uint8_t *out_end = out + out_size;
+  const uint8_t *literals = in;
+  const uint8_t *p = in;
+
+  /* Positions are stored plus one, so 0 marks an empty slot */
+  memset (lz_table, 0, sizeof lz_table);
+
+  while (p <= match_limit) {
+    unsigned h = lz_hash (p);
+    size_t candidate = lz_table[h];
+    lz_table[h] = (p - in) + 1;
+
+    if (candidate != 0) {
+      const uint8_t *match = in + candidate - 1;
+      size_t distance = p - match;
+      if (distance <= UINT16_MAX && memcmp (match, p, LZ_MIN_MATCH) == 0) {
+        size_t length = LZ_MIN_MATCH;
+        while (p + length < in_end && length < LZ_MAX_MATCH && match[length] == p[length]) {
+          length++;
+        }
+
+        out = lz_emit_literals (literals, p, out, out_end);
+        if (out == NULL || out + 3 > out_end) {
+          return 0;
+        }
+        *out++ = 0x80 | (length - LZ_MIN_MATCH);
+        *out++ = distance & 0xff;
+        *out++ = distance >> 8;
+
+        p += length;
+        literals = p;
+        continue;
+      }
+    }
+    p++;
+  }
+
+  out = lz_emit_literals (literals, in_end, out, out_end);
+  if (out == NULL) {
+    return 0;
+  }
+  return out - out_start;
+}
+
+/*
+  Decompresses SIZE bytes of compressed data at IN into the page at OUT
+*/
+static void
+lz_decompress (const uint8_t *in, size_t size, uint8_t *out) {
+  const uint8_t *in_end = in + size;
+  uint8_t *out_start = out;
+
+  while (in < in_end) {
+    uint8_t token = *in++;
+    if (token < 0x80) {
+      size_t run = token + 1;
+      memcpy (out, in, run);
+      in += run;
+      out += run;
+    } else {
+      size_t length = (token & 0x7f) + LZ_MIN_MATCH;
+      size_t distance = in[0] | (in[1] << 8);
+      in += 2;
+      ASSERT (distance > 0 && distance <= (size_t) (out - out_start));
+
+      /* Byte by byte, as the match may overlap the bytes being written */
+      const uint8_t *match = out - distance;
+      for (size_t i = 0; i < length; i++) {
+        out[i] = match[i];
+      }
+      out += length;
+    }
+  }
+  ASSERT (out == out_start + PGSIZE);
+}
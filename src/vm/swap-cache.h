@@ -0,0 +1,47 @@
+#ifndef VM_SWAP_CACHE_H
+#define VM_SWAP_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Maximum number of kernel pages used to hold compressed pages */
+#define SWAP_CACHE_PAGES (64)
+
+/* Size in bytes of the chunks the cache's pages are divided into */
+#define SWAP_CACHE_CHUNK_SIZE (64)
+
+/* Pages that do not compress to at most this many bytes go to the swap device */
+#define SWAP_CACHE_MAX_COMPRESSED (PGSIZE / 2)
+
+/* Compressed swap cache statistics */
+extern long long swap_cache_stores;     /* Pages stored compressed */
+extern long long swap_cache_loads;      /* Pages decompressed on a swap fault */
+extern long long swap_cache_rejects;    /* Pages that did not compress */
+extern long long swap_cache_full;       /* Pages turned away because the cache was full */
+
+/*
+	Initialises the compressed swap cache. Its pages are only allocated from
+	the kernel pool once they are needed
+*/
+void swap_cache_init (void);
+
+/*
+	Compresses PAGE into the cache, storing the first chunk it occupies in
+	CHUNK and its compressed size in SIZE. Returns false if the page does not
+	compress well or the cache has no room for it
+*/
+bool swap_cache_store (const void *page, size_t *chunk, uint16_t *size);
+
+/*
+	Decompresses the page stored at CHUNK with compressed size SIZE into PAGE,
+	leaving it in the cache
+*/
+void swap_cache_read (size_t chunk, uint16_t size, void *page);
+
+/*
+	Frees the chunks of the page stored at CHUNK with compressed size SIZE
+*/
+void swap_cache_free (size_t chunk, uint16_t size);
+
+#endif /* vm/swap-cache.h */
@@ -1,143 +1,247 @@
 #include "swap.h"
-#include "threads/malloc.h"
 #include "threads/synch.h"
 #include <debug.h>
 #include <stdio.h>
 #include "vm/supp-page-table.h"
+#include "vm/swap-cache.h"
+#include "vm/stats.h"
+#include "vm/frame.h"
 
-struct lock swap_table_lock;
-struct lock bitmap_lock;
-struct hash swap_table;
+/* Occupancy of the page slots of BLOCK_SWAP */
+static struct bitmap *slot_bitmap;
 
-static unsigned swap_hash (const struct hash_elem *, void *);
-static bool swap_hash_compare (const struct hash_elem *, const struct hash_elem *, void *);
-static void acquire_locks_for_swap (void);
-static void release_locks_for_swap (void);
+/* 
+    Recently freed slots, still marked as used in slot_bitmap, handed out 
+    again without scanning the bitmap
+*/
+static size_t free_slot_cache[FREE_SLOT_CACHE_SIZE];
+static size_t free_slot_cache_cnt;
+
+/* Lock to ensure synchronized access to the slot bitmap and free slot cache */
+static struct lock swap_slot_lock;
+
+long long swap_read_ahead_pages;
+long long swap_read_ahead_hits;
+long long swap_read_ahead_wasted;
+
+static size_t allocate_swap_slot (void);
+static void free_swap_slot (size_t);
+static void write_swap_slot (size_t, void *);
+static void read_swap_slot (size_t, void *);
+static bool load_page_into_swap_cache (supp_pte *, void *);
+static void read_swap_page (supp_pte *, void *);
 
 void initialise_swap_space (void) {
     /* Initialise bitmap */
-    sector_bitmap = bitmap_create (NUM_SWAP_BLOCK_SECTORS);
+    slot_bitmap = bitmap_create (NUM_SWAP_SLOTS);
+    free_slot_cache_cnt = 0;
 
-    /* Initialise hash table */
-    bool hash_created = hash_init (&swap_table, swap_hash, swap_hash_compare, NULL);
-    ASSERT (hash_created);
+    /* Initialise slot lock */
+    lock_init (&swap_slot_lock);
 
-    /* Initialise swap table and bitmap lock */
-    lock_init (&swap_table_lock);
-    lock_init (&bitmap_lock);
+    /* Initialise compressed swap cache */
+    swap_cache_init ();
 }
 
 bool load_page_into_swap_space (supp_pte *supp_entry, void *page) {
-    acquire_locks_for_swap ();
+    if (load_page_into_swap_cache (supp_entry, page)) {
+        return true;
+    }
+
+    size_t slot = allocate_swap_slot ();
+    if (slot == BITMAP_ERROR) {
+        return false;
+    }
+
+    supp_entry->swap_slot = slot;
+    write_swap_slot (slot, page);
+    return true;
+}
+
+bool load_pages_into_swap_space (supp_pte **supp_entries, void **pages, size_t page_count) {
+    ASSERT (page_count <= EVICTION_BATCH_SIZE);
 
     /*
-        Finds first contiguous sectors of BLOCK_SWAP to store whole page
+        Pages that compress are kept in the swap cache, the rest are 
+        gathered to be written to BLOCK_SWAP
     */
-    size_t index = bitmap_scan_and_flip (sector_bitmap, FIRST_SECTOR, SECTORS_PER_PAGE, false);
-    if (index == BITMAP_ERROR) {
-        release_locks_for_swap ();
-        return false;
+    supp_pte *disk_entries[EVICTION_BATCH_SIZE];
+    void *disk_pages[EVICTION_BATCH_SIZE];
+    size_t disk_count = 0;
+    for (size_t i = 0; i < page_count; i++) {
+        if (!load_page_into_swap_cache (supp_entries[i], pages[i])) {
+            disk_entries[disk_count] = supp_entries[i];
+            disk_pages[disk_count] = pages[i];
+            disk_count++;
+        }
+    }
+    if (disk_count == 0) {
+        return true;
     }
 
     /*
-      Insert first sector into swap table 
+        Finds one run of contiguous slots large enough for every page
     */
-    swap_entry *new_entry = (swap_entry *) malloc (sizeof (swap_entry));
-    new_entry->supp_pte = supp_entry;
-    new_entry->index = index;
-    hash_insert (&swap_table, &new_entry->elem);
+    lock_acquire (&swap_slot_lock);
+    size_t slot = bitmap_scan_and_flip (slot_bitmap, 0, disk_count, false);
+    if (slot != BITMAP_ERROR) {
+        vm_stats.swap_slots_used += disk_count;
+    }
+    lock_release (&swap_slot_lock);
+
+    if (slot == BITMAP_ERROR) {
+        bool success = true;
+        for (size_t i = 0; i < disk_count; i++) {
+            if (!load_page_into_swap_space (disk_entries[i], disk_pages[i])) {
+                disk_entries[i]->is_in_swap_space = false;
+                success = false;
+            }
+        }
+        return success;
+    }
 
     /* 
-        Writes each sector of page to a sector of BLOCK_SWAP 
+        Writes the pages back to back, so the device sees one sequential run 
     */
-    struct block *swap_block = block_get_role (BLOCK_SWAP);
-    void *start_addr = page;
-    for (int i = 0; i < SECTORS_PER_PAGE; i++) {
-        block_write (swap_block, index, start_addr);
-        start_addr += BLOCK_SECTOR_SIZE;
-        index++;
+    for (size_t i = 0; i < disk_count; i++) {
+        disk_entries[i]->swap_slot = slot + i;
+        write_swap_slot (slot + i, disk_pages[i]);
     }
-
-    release_locks_for_swap ();
     return true;
 }
 
 void retrieve_from_swap_space (supp_pte *supp_entry, void *empty_page) {
-    lock_acquire (&swap_table_lock);
+    read_swap_page (supp_entry, empty_page);
+    release_swap_slot (supp_entry);
+}
 
-    void *start_addr = empty_page;
-    struct block *swap_block = block_get_role (BLOCK_SWAP);
-    swap_entry entry;
-    entry.supp_pte = supp_entry;
+bool copy_swap_page (supp_pte *from, supp_pte *to, void *buffer) {
+    if (!from->is_in_swap_space) {
+        return false;
+    }
 
     /* 
-        Find index of first sector of page from swap table 
+        Reads the page into the buffer, leaving the original slot occupied
     */
-    struct hash_elem *found_elem = hash_find (&swap_table, &entry.elem);
-
-    ASSERT(found_elem);
-    
-    size_t index = hash_entry (found_elem, swap_entry, elem)->index;
+    read_swap_page (from, buffer);
+    return load_page_into_swap_space (to, buffer);
+}
 
-    /* 
-        Reads each sector of page from BLOCK_SWAP into page buffer
-        and resets the corresponding bit in sector_bitmap
-    */
-    for (int i = 0; i < SECTORS_PER_PAGE; i++) {
-        
-        block_read (swap_block, index, start_addr);
-        bitmap_flip (sector_bitmap, index);
+void release_swap_slot (supp_pte *supp_entry) {
+    if (supp_entry->swap_slot == BITMAP_ERROR) {
+        swap_cache_free (supp_entry->swap_cache_chunk, supp_entry->swap_cache_size);
+    } else {
+        free_swap_slot (supp_entry->swap_slot);
+    }
+    supp_entry->swap_slot = BITMAP_ERROR;
+}
 
-        start_addr += BLOCK_SECTOR_SIZE;
-        index++;
+void swap_read_ahead_hit (struct thread *t) {
+    swap_read_ahead_hits++;
+    if (t->swap_read_ahead_window < SWAP_READ_AHEAD_MAX) {
+        t->swap_read_ahead_window++;
     }
-    struct hash_elem *deleted = hash_delete (&swap_table, found_elem);
-    free (hash_entry (deleted, swap_entry, elem));
+}
 
-    lock_release (&swap_table_lock);
+void swap_read_ahead_miss (struct thread *t) {
+    swap_read_ahead_wasted++;
+    t->swap_read_ahead_window /= 2;
+    if (t->swap_read_ahead_window < SWAP_READ_AHEAD_MIN) {
+        t->swap_read_ahead_window = SWAP_READ_AHEAD_MIN;
+    }
 }
 
-/* 
-  Hash function for Swap Table 
+/*
+  Allocates a free page slot, preferring a recently freed one.
+  Returns BITMAP_ERROR if BLOCK_SWAP is full
 */
-static unsigned 
-swap_hash (const struct hash_elem *e, void *aux UNUSED) {
-  const swap_entry *entry = hash_entry (e, swap_entry, elem);
-  return hash_bytes (&entry->supp_pte, sizeof entry->supp_pte);
+static size_t
+allocate_swap_slot (void) {
+  lock_acquire (&swap_slot_lock);
+
+  size_t slot;
+  if (free_slot_cache_cnt > 0) {
+    slot = free_slot_cache[--free_slot_cache_cnt];
+  } else {
+    slot = bitmap_scan_and_flip (slot_bitmap, 0, 1, false);
+  }
+  if (slot != BITMAP_ERROR) {
+    vm_stats.swap_slots_used++;
+  }
+
+  lock_release (&swap_slot_lock);
+  return slot;
 }
 
-/* 
-  Comparison function for Swap Page Table
-    - compares the base addresses (indices) of two hash table entries
+/*
+  Frees the page slot, keeping it in the free slot cache if there is room
 */
-static bool 
-swap_hash_compare (const struct hash_elem *a, const struct hash_elem *b, void *aux UNUSED) {
-  const swap_entry *entryA = hash_entry (a, swap_entry, elem);
-  const swap_entry *entryB = hash_entry (b, swap_entry, elem);
+static void
+free_swap_slot (size_t slot) {
+  lock_acquire (&swap_slot_lock);
 
-  if (entryA->supp_pte->thread->tid < entryB->supp_pte->thread->tid) {
-    return true;
-  } else if (entryA->supp_pte->thread->tid == entryB->supp_pte->thread->tid){
-    return entryA->supp_pte->uaddr < entryB->supp_pte->uaddr;
+  ASSERT (bitmap_test (slot_bitmap, slot));
+  vm_stats.swap_slots_used--;
+  if (free_slot_cache_cnt < FREE_SLOT_CACHE_SIZE) {
+    free_slot_cache[free_slot_cache_cnt++] = slot;
   } else {
-    return false;
+    bitmap_reset (slot_bitmap, slot);
   }
+
+  lock_release (&swap_slot_lock);
 }
 
 /*
-  Acquire swap_table_lock and bitmap_lock together when writing to swap space
+  Writes each sector of PAGE to the sectors of the page slot
 */
 static void
-acquire_locks_for_swap () {
-  lock_acquire (&bitmap_lock);
-  lock_acquire (&swap_table_lock);
+write_swap_slot (size_t slot, void *page) {
+  struct block *swap_block = block_get_role (BLOCK_SWAP);
+  block_sector_t sector = slot * SECTORS_PER_PAGE;
+  for (int i = 0; i < SECTORS_PER_PAGE; i++) {
+    block_write (swap_block, sector + i, page + i * BLOCK_SECTOR_SIZE);
+  }
+  vm_stats.swap_writes++;
 }
 
-/* 
-  Release swap_table_lock and bitmap_lock when finished writing to swap space
+/*
+  Reads each sector of the page slot into PAGE
 */
 static void
-release_locks_for_swap () {
-  lock_release (&swap_table_lock);
-  lock_release (&bitmap_lock);
-}
\ No newline at end of file
+read_swap_slot (size_t slot, void *page) {
+  struct block *swap_block = block_get_role (BLOCK_SWAP);
+  block_sector_t sector = slot * SECTORS_PER_PAGE;
+  for (int i = 0; i < SECTORS_PER_PAGE; i++) {
+    block_read (swap_block, sector + i, page + i * BLOCK_SECTOR_SIZE);
+  }
+}
+
+/*
+  Tries to keep PAGE compressed in the swap cache instead of writing it to
+  BLOCK_SWAP
+*/
+static bool
+load_page_into_swap_cache (supp_pte *supp_entry, void *page) {
+  size_t chunk;
+  uint16_t size;
+  if (!swap_cache_store (page, &chunk, &size)) {
+    return false;
+  }
+  supp_entry->swap_slot = BITMAP_ERROR;
+  supp_entry->swap_cache_chunk = chunk;
+  supp_entry->swap_cache_size = size;
+  return true;
+}
+
+/*
+  Reads the swapped out page of SUPP_ENTRY into PAGE, without releasing
+  its slot
+*/
+static void
+read_swap_page (supp_pte *supp_entry, void *page) {
+  if (supp_entry->swap_slot == BITMAP_ERROR) {
+    swap_cache_read (supp_entry->swap_cache_chunk, supp_entry->swap_cache_size, page);
+  } else {
+    read_swap_slot (supp_entry->swap_slot, page);
+  }
+}
@@ -5,7 +5,6 @@
 #include <inttypes.h>
 #include <stddef.h>
 #include "lib/kernel/bitmap.h"
-#include "lib/kernel/hash.h"
 #include "threads/vaddr.h"
 #include "devices/block.h"
 #include "vm/supp-page-table.h"
@@ -16,48 +15,72 @@
 /* Calculates the number of sectors needed to store a page */
 #define SECTORS_PER_PAGE (PGSIZE / BLOCK_SECTOR_SIZE)
 
-/* Index of first sector of a block */
-#define FIRST_SECTOR (0)
+/* Calculates number of page slots in BLOCK_SWAP */
+#define NUM_SWAP_SLOTS (NUM_SWAP_BLOCK_SECTORS / SECTORS_PER_PAGE)
 
-/* Bitmap to record occupancy of swap spaces */
-struct bitmap *sector_bitmap;
+/* Number of freed slots kept for reuse without scanning the slot bitmap */
+#define FREE_SLOT_CACHE_SIZE (32)
 
-/* Swap Table */
-extern struct hash swap_table;
+/* Initial, minimum and maximum number of pages read ahead on a swap fault */
+#define SWAP_READ_AHEAD_INITIAL (2)
+#define SWAP_READ_AHEAD_MIN (1)
+#define SWAP_READ_AHEAD_MAX (16)
+
+/* Swap read-ahead statistics */
+extern long long swap_read_ahead_pages;     /* Pages brought in speculatively */
+extern long long swap_read_ahead_hits;      /* Speculative pages later accessed */
+extern long long swap_read_ahead_wasted;    /* Speculative pages evicted untouched */
+
+/*
+	Initialise bitmap to represent occupied page slots and the swap cache
+*/
+void initialise_swap_space (void);
 
 /*
-  Struct for an entry in swap table
+	Stores the contents of PAGE compressed in the swap cache, or, if the cache
+	is full or the page does not compress, writes it to a free page slot in
+	BLOCK_SWAP. The location is recorded in SUPP_ENTRY
 */
-typedef struct {
-	supp_pte *supp_pte;           /* Supplemental Page table entry */
-	size_t index;                 /* Index of first block sector in device */
+bool load_page_into_swap_space (supp_pte *, void *);
 
-  struct hash_elem elem;          /* Hash table elem */
-} swap_entry;
+/*
+	Stores the contents of PAGE_COUNT pages in the swap cache where possible
+	and writes the rest to one contiguous run of slots in BLOCK_SWAP, so
+	they are written in a single sequential pass. Falls back to writing the
+	pages separately if no such run is free. At most EVICTION_BATCH_SIZE 
+	pages are stored at once, and the arrays are left unchanged. Returns
+	false if swap space filled up, in which case the entries of the pages
+	that were not stored have is_in_swap_space cleared
+*/
+bool load_pages_into_swap_space (supp_pte **, void **, size_t);
 
 /*
-  Lock to ensure synchronized access to the swap table
+	Gives TO its own copy of the swapped out page of FROM, using BUFFER as a
+	page sized bounce buffer. Returns false if FROM is not in swap space or
+	no slot is free for the copy
 */
-extern struct lock swap_table_lock;
+bool copy_swap_page (supp_pte *, supp_pte *, void *);
 
 /*
-  Lock to ensure synchronized access to the bitmap
+	Frees the swap slot or swap cache chunks holding the page of SUPP_ENTRY
 */
-extern struct lock bitmap_lock;
+void release_swap_slot (supp_pte *);
 
 /*
-	Initialise Swap Table hash table and bitmap to represent occupied sectors
+	Records that a page read ahead for the thread was accessed, widening its
+	read-ahead window
 */
-void initialise_swap_space (void);
+void swap_read_ahead_hit (struct thread *);
 
 /*
-	Writes contents of PAGE to first available contiguous SECTORS_PER_PAGE 
-	sectors in BLOCK_SWAP
+	Records that a page read ahead for the thread was evicted without being
+	accessed, narrowing its read-ahead window
 */
-bool load_page_into_swap_space (supp_pte *, void *);
+void swap_read_ahead_miss (struct thread *);
 
 /* 
-	Populates EMPTY_PAGE with data from SUPP_ENTRY from swap space
+	Populates EMPTY_PAGE with data from SUPP_ENTRY from swap space, releasing
+	its slot
 */
 void retrieve_from_swap_space (supp_pte *, void *);
 